@@ -33,6 +33,10 @@ public:
 	std::string json_name () const;
 	void run ();
 
+	JobResource resource () const {
+		return JOB_RESOURCE_DISK;
+	}
+
 private:
 	void audio (boost::shared_ptr<const AudioBuffers>, Time);
 
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2012-2013 Carl Hetherington <cth@carlh.net>
+    Copyright (C) 2012-2015 Carl Hetherington <cth@carlh.net>
 
     This program is free software; you can redistribute it and/or modify
     it under the terms of the GNU General Public License as published by
@@ -20,12 +20,138 @@
 #include <cstring>
 #include <cmath>
 #include <stdexcept>
+#include <map>
+#include <stdint.h>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
 #include "audio_buffers.h"
 #include "util.h"
 
 using std::bad_alloc;
+using std::map;
+using std::vector;
+using std::pair;
+using std::make_pair;
+using std::max;
 using boost::shared_ptr;
 
+/** Alignment of the start of each channel's data, in bytes */
+static size_t const alignment = 64;
+/** Smallest block that the pool hands out, in floats */
+static size_t const smallest_block = 1024;
+/** Total size of the unused blocks that the pool will keep, in floats */
+static size_t const max_spare = 16 * 1024 * 1024;
+
+/** @class AudioBlockPool
+ *  @brief Unused blocks of aligned memory for AudioBuffers, kept so that they can be re-used.
+ *
+ *  Blocks are sized in powers of two so that requests for similar sizes share blocks.
+ */
+class AudioBlockPool
+{
+public:
+	AudioBlockPool ()
+		: _spare_size (0)
+	{}
+
+	/** @param size Number of floats required; will be rounded up to the size of the block that is returned.
+	 *  @param raw Filled in with the pointer that must be passed back to put().
+	 *  @return Aligned block.
+	 */
+	float* get (size_t& size, void*& raw)
+	{
+		size_t s = smallest_block;
+		while (s < size) {
+			s *= 2;
+		}
+		size = s;
+
+		{
+			boost::mutex::scoped_lock lm (_mutex);
+			map<size_t, vector<pair<float*, void*> > >::iterator i = _spare.find (size);
+			if (i != _spare.end() && !i->second.empty ()) {
+				pair<float*, void*> b = i->second.back ();
+				i->second.pop_back ();
+				_spare_size -= size;
+				raw = b.second;
+				return b.first;
+			}
+		}
+
+		raw = malloc (size * sizeof (float) + alignment - 1);
+		if (!raw) {
+			throw bad_alloc ();
+		}
+
+		return reinterpret_cast<float*> ((reinterpret_cast<uintptr_t> (raw) + alignment - 1) & ~(alignment - 1));
+	}
+
+	void put (float* block, void* raw, size_t size)
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		if ((_spare_size + size) <= max_spare) {
+			_spare[size].push_back (make_pair (block, raw));
+			_spare_size += size;
+		} else {
+			free (raw);
+		}
+	}
+
+	static AudioBlockPool* instance ()
+	{
+		static AudioBlockPool* pool = new AudioBlockPool ();
+		return pool;
+	}
+
+private:
+	boost::mutex _mutex;
+	/** Spare blocks, indexed by their size in floats; each is an aligned pointer and the pointer that was allocated */
+	map<size_t, vector<pair<float*, void*> > > _spare;
+	/** total size of the blocks in _spare, in floats */
+	size_t _spare_size;
+};
+
+/** @class AudioBuffers::Storage
+ *  @brief A block from the AudioBlockPool, which goes back there when it is destroyed.
+ */
+class AudioBuffers::Storage : public boost::noncopyable
+{
+public:
+	explicit Storage (size_t size)
+		: _size (size)
+	{
+		_data = AudioBlockPool::instance()->get (_size, _raw);
+	}
+
+	~Storage ()
+	{
+		AudioBlockPool::instance()->put (_data, _raw, _size);
+	}
+
+	float* data () const {
+		return _data;
+	}
+
+	/** @return Number of floats in the block */
+	size_t size () const {
+		return _size;
+	}
+
+private:
+	float* _data;
+	void* _raw;
+	size_t _size;
+};
+
+/** @return frames rounded up so that channels which are this many floats apart keep their alignment */
+static int
+aligned_stride (int frames)
+{
+	int const n = alignment / sizeof (float);
+	return ((frames + n - 1) / n) * n;
+}
+
 /** Construct an AudioBuffers.  Audio data is undefined after this constructor.
  *  @param channels Number of channels.
  *  @param frames Number of frames to reserve space for.
@@ -50,6 +176,24 @@ AudioBuffers::AudioBuffers (boost::shared_ptr<const AudioBuffers> other)
 	copy_from (other.get(), other->_frames, 0, 0);
 }
 
+/** Construct a view onto some frames of another AudioBuffers; see view() */
+AudioBuffers::AudioBuffers (AudioBuffers const * parent, int offset, int frames)
+	: _channels (parent->_channels)
+	, _frames (frames)
+	, _allocated_frames (frames)
+	, _stride (parent->_stride)
+	, _storage (parent->_storage)
+{
+	_data = static_cast<float**> (malloc (max (_channels, 1) * sizeof (float *)));
+	if (!_data) {
+		throw bad_alloc ();
+	}
+
+	for (int i = 0; i < _channels; ++i) {
+		_data[i] = parent->_data[i] + offset;
+	}
+}
+
 AudioBuffers &
 AudioBuffers::operator= (AudioBuffers const & other)
 {
@@ -76,28 +220,45 @@ AudioBuffers::allocate (int channels, int frames)
 	_channels = channels;
 	_frames = frames;
 	_allocated_frames = frames;
+	_stride = aligned_stride (frames);
 
-	_data = static_cast<float**> (malloc (_channels * sizeof (float *)));
+	_data = static_cast<float**> (malloc (max (_channels, 1) * sizeof (float *)));
 	if (!_data) {
 		throw bad_alloc ();
 	}
 
-	for (int i = 0; i < _channels; ++i) {
-		_data[i] = static_cast<float*> (malloc (frames * sizeof (float)));
-		if (!_data[i]) {
-			throw bad_alloc ();
-		}
-	}
+	_storage.reset (new Storage (_channels * _stride));
+	set_pointers (_storage->data ());
 }
 
 void
 AudioBuffers::deallocate ()
+{
+	free (_data);
+	_storage.reset ();
+}
+
+/** Point _data at our channels, with the first at `base' and the others each _stride floats on */
+void
+AudioBuffers::set_pointers (float* base)
 {
 	for (int i = 0; i < _channels; ++i) {
-		free (_data[i]);
+		_data[i] = base + i * _stride;
 	}
+}
 
-	free (_data);
+/** Make a view onto some of our frames.  This shares our data rather than copying it,
+ *  so it is only valid until our data next change.
+ *  @param offset Offset of the first frame of the view within our frames.
+ *  @param frames Number of frames in the view.
+ */
+shared_ptr<const AudioBuffers>
+AudioBuffers::view (int offset, int frames) const
+{
+	DCPOMATIC_ASSERT (offset >= 0 && frames >= 0);
+	DCPOMATIC_ASSERT ((offset + frames) <= _frames);
+
+	return shared_ptr<const AudioBuffers> (new AudioBuffers (this, offset, frames));
 }
 
 /** @param c Channel index.
@@ -238,14 +399,31 @@ AudioBuffers::ensure_size (int frames)
 		return;
 	}
 
-	for (int i = 0; i < _channels; ++i) {
-		_data[i] = static_cast<float*> (realloc (_data[i], frames * sizeof (float)));
-		if (!_data[i]) {
-			throw bad_alloc ();
+	int const stride = aligned_stride (frames);
+
+	if (_storage.unique() && size_t (_channels * stride) <= _storage->size()) {
+		/* Our block is big enough; spread the channels out within it, starting
+		   with the last so that we never overwrite data that have not yet moved.
+		*/
+		float* base = _storage->data ();
+		for (int i = _channels - 1; i >= 0; --i) {
+			memmove (base + i * stride, _data[i], _allocated_frames * sizeof (float));
 		}
-		for (int j = _allocated_frames; j < frames; ++j) {
-			_data[i][j] = 0;
+		_stride = stride;
+		set_pointers (base);
+	} else {
+		/* Get a new block and copy what we have into it */
+		shared_ptr<Storage> storage (new Storage (_channels * stride));
+		for (int i = 0; i < _channels; ++i) {
+			memcpy (storage->data() + i * stride, _data[i], _allocated_frames * sizeof (float));
 		}
+		_storage = storage;
+		_stride = stride;
+		set_pointers (_storage->data ());
+	}
+
+	for (int i = 0; i < _channels; ++i) {
+		memset (_data[i] + _allocated_frames, 0, (frames - _allocated_frames) * sizeof (float));
 	}
 
 	_allocated_frames = frames;
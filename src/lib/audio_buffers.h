@@ -24,6 +24,11 @@
 
 /** @class AudioBuffers
  *  @brief A class to hold multi-channel audio data in float format.
+ *
+ *  The data for all channels are kept in one block of memory, with each channel
+ *  starting on a 64-byte boundary.  Blocks are taken from and returned to a
+ *  process-wide pool, so that buffers of similar sizes which are made and
+ *  thrown away again and again do not keep going back to the system allocator.
  */
 class AudioBuffers
 {
@@ -37,6 +42,8 @@ public:
 
 	void ensure_size (int);
 
+	boost::shared_ptr<const AudioBuffers> view (int offset, int frames) const;
+
 	float** data () const {
 		return _data;
 	}
@@ -65,8 +72,13 @@ public:
 	void accumulate_frames (AudioBuffers const *, int read_offset, int write_offset, int frames);
 
 private:
+	class Storage;
+
+	AudioBuffers (AudioBuffers const * parent, int offset, int frames);
+
 	void allocate (int, int);
 	void deallocate ();
+	void set_pointers (float *);
 
 	/** Number of channels */
 	int _channels;
@@ -74,8 +86,12 @@ private:
 	int _frames;
 	/** Number of frames that _data can hold */
 	int _allocated_frames;
+	/** Number of floats between the start of one channel and the start of the next */
+	int _stride;
 	/** Audio data (so that, e.g. _data[2][6] is channel 2, sample 6) */
 	float** _data;
+	/** Memory that _data points into; this may be shared with views of these buffers */
+	boost::shared_ptr<Storage> _storage;
 };
 
 #endif
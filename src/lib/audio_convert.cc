@@ -0,0 +1,189 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <cstring>
+#include <algorithm>
+#include "audio_convert.h"
+
+using std::min;
+
+/* The loops below are written to be simple enough for the compiler to vectorise:
+   each one reads samples at a fixed stride and writes floats contiguously, with
+   no per-sample branches.  Interleaved input is taken in blocks small enough to
+   stay in cache while we pick out each channel in turn.
+*/
+
+/** Number of frames of interleaved input to deinterleave at a time */
+static int const block_frames = 256;
+
+template <typename T>
+struct Sample;
+
+template <>
+struct Sample<uint8_t>
+{
+	static float to_float (uint8_t s) {
+		return (int (s) - 128) * (1.0f / 128);
+	}
+};
+
+template <>
+struct Sample<int16_t>
+{
+	static float to_float (int16_t s) {
+		return s * (1.0f / 32768);
+	}
+};
+
+template <>
+struct Sample<int32_t>
+{
+	static float to_float (int32_t s) {
+		return s * (1.0f / 2147483648.0f);
+	}
+};
+
+template <>
+struct Sample<float>
+{
+	static float to_float (float s) {
+		return s;
+	}
+};
+
+/** Deinterleave with a channel count that is known at compile time, so that the stride
+ *  of the inner loop is a constant.
+ */
+template <typename T, int C>
+static void
+deinterleave_fixed (T const * in, int frames, float** out)
+{
+	for (int b = 0; b < frames; b += block_frames) {
+		int const n = min (block_frames, frames - b);
+		T const * block = in + b * C;
+		for (int c = 0; c < C; ++c) {
+			T const * p = block + c;
+			float* q = out[c] + b;
+			for (int f = 0; f < n; ++f) {
+				q[f] = Sample<T>::to_float (p[f * C]);
+			}
+		}
+	}
+}
+
+/** Deinterleave with any channel count */
+template <typename T>
+static void
+deinterleave_any (T const * in, int channels, int frames, float** out)
+{
+	for (int b = 0; b < frames; b += block_frames) {
+		int const n = min (block_frames, frames - b);
+		T const * block = in + b * channels;
+		for (int c = 0; c < channels; ++c) {
+			T const * p = block + c;
+			float* q = out[c] + b;
+			for (int f = 0; f < n; ++f) {
+				q[f] = Sample<T>::to_float (p[f * channels]);
+			}
+		}
+	}
+}
+
+template <typename T>
+static void
+deinterleave (T const * in, int channels, int frames, float** out)
+{
+	switch (channels) {
+	case 1:
+		deinterleave_fixed<T, 1> (in, frames, out);
+		break;
+	case 2:
+		deinterleave_fixed<T, 2> (in, frames, out);
+		break;
+	case 6:
+		deinterleave_fixed<T, 6> (in, frames, out);
+		break;
+	case 8:
+		deinterleave_fixed<T, 8> (in, frames, out);
+		break;
+	case 16:
+		deinterleave_fixed<T, 16> (in, frames, out);
+		break;
+	default:
+		deinterleave_any<T> (in, channels, frames, out);
+		break;
+	}
+}
+
+template <typename T>
+static void
+convert (T const * in, int frames, float* out)
+{
+	for (int f = 0; f < frames; ++f) {
+		out[f] = Sample<T>::to_float (in[f]);
+	}
+}
+
+void
+deinterleave_samples (uint8_t const * in, int channels, int frames, float** out)
+{
+	deinterleave (in, channels, frames, out);
+}
+
+void
+deinterleave_samples (int16_t const * in, int channels, int frames, float** out)
+{
+	deinterleave (in, channels, frames, out);
+}
+
+void
+deinterleave_samples (int32_t const * in, int channels, int frames, float** out)
+{
+	deinterleave (in, channels, frames, out);
+}
+
+void
+deinterleave_samples (float const * in, int channels, int frames, float** out)
+{
+	deinterleave (in, channels, frames, out);
+}
+
+void
+convert_samples (uint8_t const * in, int frames, float* out)
+{
+	convert (in, frames, out);
+}
+
+void
+convert_samples (int16_t const * in, int frames, float* out)
+{
+	convert (in, frames, out);
+}
+
+void
+convert_samples (int32_t const * in, int frames, float* out)
+{
+	convert (in, frames, out);
+}
+
+void
+convert_samples (float const * in, int frames, float* out)
+{
+	memcpy (out, in, frames * sizeof (float));
+}
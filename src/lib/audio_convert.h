@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef DCPOMATIC_AUDIO_CONVERT_H
+#define DCPOMATIC_AUDIO_CONVERT_H
+
+/** @file  src/lib/audio_convert.h
+ *  @brief Conversion of audio samples from decoders into the float format used by AudioBuffers.
+ *
+ *  Unsigned 8-bit samples are offset by 128; all integer samples are scaled so that
+ *  full scale becomes [-1, 1).
+ */
+
+#include <stdint.h>
+
+/* Split `frames' frames of `channels'-channel interleaved samples from `in' into
+   one buffer per channel in `out', converting to float.
+*/
+extern void deinterleave_samples (uint8_t const * in, int channels, int frames, float** out);
+extern void deinterleave_samples (int16_t const * in, int channels, int frames, float** out);
+extern void deinterleave_samples (int32_t const * in, int channels, int frames, float** out);
+extern void deinterleave_samples (float const * in, int channels, int frames, float** out);
+
+/* Convert `frames' samples of a single channel from `in' to float in `out' */
+extern void convert_samples (uint8_t const * in, int frames, float* out);
+extern void convert_samples (int16_t const * in, int frames, float* out);
+extern void convert_samples (int32_t const * in, int frames, float* out);
+extern void convert_samples (float const * in, int frames, float* out);
+
+#endif
@@ -17,12 +17,15 @@
 
 */
 
+#include <cstring>
+#include <cmath>
 #include <libxml++/libxml++.h>
 #include <libcxml/cxml.h>
 #include "raw_convert.h"
 #include "audio_mapping.h"
 #include "util.h"
 #include "md5_digester.h"
+#include "audio_buffers.h"
 
 using std::list;
 using std::cout;
@@ -191,3 +194,66 @@ AudioMapping::set_name (int channel, string name)
 {
 	_name[channel] = name;
 }
+
+/** @param mapping Mapping to use.
+ *  @param gain Gain to apply to all the content, in dB.
+ *  @param output_channels Number of output (DCP) channels.
+ */
+AudioMixingPlan::AudioMixingPlan (AudioMapping const & mapping, float gain, int output_channels)
+{
+	DCPOMATIC_ASSERT (output_channels <= MAX_DCP_AUDIO_CHANNELS);
+
+	float const linear = pow (10, gain / 20);
+
+	_sources.resize (output_channels);
+	for (int i = 0; i < mapping.content_channels(); ++i) {
+		for (int j = 0; j < output_channels; ++j) {
+			float const g = mapping.get (i, static_cast<libdcp::Channel> (j));
+			if (g > 0) {
+				_sources[j].push_back (Source (i, g * linear));
+			}
+		}
+	}
+}
+
+/** Mix some audio according to this plan.  Each output channel is written in one pass
+ *  over its first source, and then one more pass for each other source;
+ *  the loops are simple enough for the compiler to vectorise.
+ *
+ *  @param in Content audio.
+ *  @param out Buffers to write mixed audio to; these must have the number of output channels
+ *  that this plan was made for, and at least as many frames as `in'.  Existing data in `out'
+ *  is overwritten.
+ */
+void
+AudioMixingPlan::run (AudioBuffers const * in, AudioBuffers* out) const
+{
+	DCPOMATIC_ASSERT (out->channels() == int (_sources.size ()));
+
+	int const frames = in->frames ();
+	out->set_frames (frames);
+
+	for (size_t i = 0; i < _sources.size(); ++i) {
+		float* o = out->data (i);
+		vector<Source> const & sources = _sources[i];
+
+		if (sources.empty ()) {
+			memset (o, 0, frames * sizeof (float));
+			continue;
+		}
+
+		float const * s = in->data (sources[0].channel);
+		float const g = sources[0].gain;
+		for (int j = 0; j < frames; ++j) {
+			o[j] = s[j] * g;
+		}
+
+		for (size_t k = 1; k < sources.size(); ++k) {
+			float const * s = in->data (sources[k].channel);
+			float const g = sources[k].gain;
+			for (int j = 0; j < frames; ++j) {
+				o[j] += s[j] * g;
+			}
+		}
+	}
+}
@@ -33,6 +33,8 @@ namespace cxml {
 	class Node;
 }
 
+class AudioBuffers;
+
 /** A many-to-many mapping from some content channels to DCP channels.
  *  The number of content channels is set on construction and fixed,
  *  and then each of those content channels are mapped to each DCP channel
@@ -77,4 +79,35 @@ private:
 	std::vector<std::string> _name;
 };
 
+/** @class AudioMixingPlan
+ *  @brief An AudioMapping prepared for mixing audio quickly.
+ *
+ *  Only the non-zero gains from the mapping are kept, arranged by output channel,
+ *  and a gain for all the content is folded into them.
+ */
+class AudioMixingPlan
+{
+public:
+	AudioMixingPlan (AudioMapping const & mapping, float gain, int output_channels);
+
+	void run (AudioBuffers const * in, AudioBuffers* out) const;
+
+private:
+	struct Source
+	{
+		Source (int c, float g)
+			: channel (c)
+			, gain (g)
+		{}
+
+		/** content channel */
+		int channel;
+		/** linear gain */
+		float gain;
+	};
+
+	/** sources of audio for each output channel */
+	std::vector<std::vector<Source> > _sources;
+};
+
 #endif
@@ -0,0 +1,122 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "black_frame_cache.h"
+#include "player_video_frame.h"
+
+using std::map;
+using boost::shared_ptr;
+
+BlackFrameCache* BlackFrameCache::_instance = 0;
+boost::mutex BlackFrameCache::_instance_mutex;
+
+BlackFrameCache::Key::Key (
+	shared_ptr<const PlayerVideoFrame> frame, int frames_per_second_, int j2k_bandwidth_, Resolution resolution_, bool interop_
+	)
+	: width (frame->out_size().width)
+	, height (frame->out_size().height)
+	, frames_per_second (frames_per_second_)
+	, j2k_bandwidth (j2k_bandwidth_)
+	, resolution (resolution_)
+	, one_eye (frame->eyes() == EYES_LEFT || frame->eyes() == EYES_RIGHT)
+	, interop (interop_)
+{
+
+}
+
+bool
+BlackFrameCache::Key::operator< (Key const & other) const
+{
+	if (width != other.width) {
+		return width < other.width;
+	}
+
+	if (height != other.height) {
+		return height < other.height;
+	}
+
+	if (frames_per_second != other.frames_per_second) {
+		return frames_per_second < other.frames_per_second;
+	}
+
+	if (j2k_bandwidth != other.j2k_bandwidth) {
+		return j2k_bandwidth < other.j2k_bandwidth;
+	}
+
+	if (resolution != other.resolution) {
+		return resolution < other.resolution;
+	}
+
+	if (one_eye != other.one_eye) {
+		return one_eye < other.one_eye;
+	}
+
+	return interop < other.interop;
+}
+
+/** @param frame A black frame.
+ *  @return Encoded version of the frame for the given parameters, or 0 if we do not have one.
+ */
+shared_ptr<const EncodedData>
+BlackFrameCache::get (
+	shared_ptr<const PlayerVideoFrame> frame, int frames_per_second, int j2k_bandwidth, Resolution resolution, bool interop
+	)
+{
+	Key const key (frame, frames_per_second, j2k_bandwidth, resolution, interop);
+
+	boost::mutex::scoped_lock lm (_mutex);
+	map<Key, shared_ptr<const EncodedData> >::const_iterator i = _frames.find (key);
+	if (i == _frames.end ()) {
+		return shared_ptr<const EncodedData> ();
+	}
+
+	return i->second;
+}
+
+/** Remember the encoded version of a black frame.
+ *  @param frame A black frame.
+ *  @param encoded frame, encoded with the given parameters.
+ */
+void
+BlackFrameCache::add (
+	shared_ptr<const PlayerVideoFrame> frame,
+	int frames_per_second,
+	int j2k_bandwidth,
+	Resolution resolution,
+	bool interop,
+	shared_ptr<const EncodedData> encoded
+	)
+{
+	Key const key (frame, frames_per_second, j2k_bandwidth, resolution, interop);
+
+	boost::mutex::scoped_lock lm (_mutex);
+	_frames[key] = encoded;
+}
+
+BlackFrameCache*
+BlackFrameCache::instance ()
+{
+	/* We can be called from several encoders' threads at once */
+	boost::mutex::scoped_lock lm (_instance_mutex);
+	if (!_instance) {
+		_instance = new BlackFrameCache ();
+	}
+
+	return _instance;
+}
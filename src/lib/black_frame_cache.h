@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef DCPOMATIC_BLACK_FRAME_CACHE_H
+#define DCPOMATIC_BLACK_FRAME_CACHE_H
+
+/** @file  src/lib/black_frame_cache.h
+ *  @brief BlackFrameCache class.
+ */
+
+#include <map>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include "types.h"
+
+class EncodedData;
+class PlayerVideoFrame;
+
+/** @class BlackFrameCache
+ *  @brief A process-wide cache of JPEG2000-encoded black frames.
+ *
+ *  Black frames for a given set of encoding parameters are always the same,
+ *  so once one has been encoded it can be re-used for every subsequent run
+ *  of black (in this film or any other).  Encoding is not done here; the
+ *  first black frame of each kind is encoded like any other frame, then
+ *  given to add().
+ */
+class BlackFrameCache : public boost::noncopyable
+{
+public:
+	boost::shared_ptr<const EncodedData> get (
+		boost::shared_ptr<const PlayerVideoFrame> frame,
+		int frames_per_second,
+		int j2k_bandwidth,
+		Resolution resolution,
+		bool interop
+		);
+
+	void add (
+		boost::shared_ptr<const PlayerVideoFrame> frame,
+		int frames_per_second,
+		int j2k_bandwidth,
+		Resolution resolution,
+		bool interop,
+		boost::shared_ptr<const EncodedData> encoded
+		);
+
+	static BlackFrameCache* instance ();
+
+private:
+	BlackFrameCache () {}
+
+	struct Key
+	{
+		Key (boost::shared_ptr<const PlayerVideoFrame> frame, int frames_per_second, int j2k_bandwidth, Resolution resolution, bool interop);
+
+		int width;
+		int height;
+		int frames_per_second;
+		int j2k_bandwidth;
+		Resolution resolution;
+		/** true if the frame is one eye of a 3D pair; either eye is encoded with half
+		    the bandwidth of a 2D frame, but otherwise the same.
+		*/
+		bool one_eye;
+		bool interop;
+
+		bool operator< (Key const & other) const;
+	};
+
+	/** Mutex for _frames */
+	boost::mutex _mutex;
+	std::map<Key, boost::shared_ptr<const EncodedData> > _frames;
+
+	static BlackFrameCache* _instance;
+	static boost::mutex _instance_mutex;
+};
+
+#endif
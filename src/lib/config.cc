@@ -104,6 +104,16 @@ Config::set_defaults ()
 	_check_for_test_updates = false;
 	_maximum_j2k_bandwidth = 250000000;
 	_log_types = Log::TYPE_GENERAL | Log::TYPE_WARNING | Log::TYPE_ERROR;
+	_detect_duplicate_frames = false;
+	_memory_budget = 1024;
+	_maximum_jobs[JOB_RESOURCE_CPU] = 1;
+	_maximum_jobs[JOB_RESOURCE_DISK] = 2;
+	_maximum_jobs[JOB_RESOURCE_NETWORK] = 2;
+	_content_read_buffer = 1024;
+	_content_read_ahead = true;
+	_image_prefetch_depth = 8;
+	_image_prefetch_threads = 4;
+	_use_examination_cache = true;
 
 	_allowed_dcp_frame_rates.clear ();
 
@@ -219,6 +229,21 @@ Config::read ()
 
 	_log_types = f.optional_number_child<int> ("LogTypes").get_value_or (Log::TYPE_GENERAL | Log::TYPE_WARNING | Log::TYPE_ERROR);
 
+	_detect_duplicate_frames = f.optional_bool_child("DetectDuplicateFrames").get_value_or (false);
+	_memory_budget = f.optional_number_child<int> ("MemoryBudget").get_value_or (1024);
+	_maximum_jobs[JOB_RESOURCE_CPU] = f.optional_number_child<int> ("MaximumCPUJobs").get_value_or (1);
+	_maximum_jobs[JOB_RESOURCE_DISK] = f.optional_number_child<int> ("MaximumDiskJobs").get_value_or (2);
+	_maximum_jobs[JOB_RESOURCE_NETWORK] = f.optional_number_child<int> ("MaximumNetworkJobs").get_value_or (2);
+	_content_read_buffer = f.optional_number_child<int> ("ContentReadBuffer").get_value_or (1024);
+	_content_read_ahead = f.optional_bool_child("ContentReadAhead").get_value_or (true);
+	_image_prefetch_depth = f.optional_number_child<int> ("ImagePrefetchDepth").get_value_or (8);
+	_image_prefetch_threads = f.optional_number_child<int> ("ImagePrefetchThreads").get_value_or (4);
+	_use_examination_cache = f.optional_bool_child("UseExaminationCache").get_value_or (true);
+	c = f.optional_string_child ("ExaminationCacheDirectory");
+	if (c) {
+		_examination_cache_directory = boost::filesystem::path (c.get ());
+	}
+
 	list<cxml::NodePtr> his = f.node_children ("History");
 	for (list<cxml::NodePtr>::const_iterator i = his.begin(); i != his.end(); ++i) {
 		_history.push_back ((*i)->content ());
@@ -261,6 +286,21 @@ Config::signer_chain_directory () const
 	return p;
 }
 
+/** @return Directory in which to keep digests and examination results of content files */
+boost::filesystem::path
+Config::examination_cache_directory () const
+{
+	boost::filesystem::path p;
+	if (_examination_cache_directory) {
+		p = _examination_cache_directory.get ();
+	} else {
+		p = base_directory ();
+		p /= "examination_cache";
+	}
+	boost::filesystem::create_directories (p);
+	return p;
+}
+
 /** @return Singleton instance */
 Config *
 Config::instance ()
@@ -342,6 +382,19 @@ Config::write () const
 	root->add_child("MaximumJ2KBandwidth")->add_child_text (raw_convert<string> (_maximum_j2k_bandwidth));
 	root->add_child("AllowAnyDCPFrameRate")->add_child_text (_allow_any_dcp_frame_rate ? "1" : "0");
 	root->add_child("LogTypes")->add_child_text (raw_convert<string> (_log_types));
+	root->add_child("DetectDuplicateFrames")->add_child_text (_detect_duplicate_frames ? "1" : "0");
+	root->add_child("MemoryBudget")->add_child_text (raw_convert<string> (_memory_budget));
+	root->add_child("MaximumCPUJobs")->add_child_text (raw_convert<string> (_maximum_jobs[JOB_RESOURCE_CPU]));
+	root->add_child("MaximumDiskJobs")->add_child_text (raw_convert<string> (_maximum_jobs[JOB_RESOURCE_DISK]));
+	root->add_child("MaximumNetworkJobs")->add_child_text (raw_convert<string> (_maximum_jobs[JOB_RESOURCE_NETWORK]));
+	root->add_child("ContentReadBuffer")->add_child_text (raw_convert<string> (_content_read_buffer));
+	root->add_child("ContentReadAhead")->add_child_text (_content_read_ahead ? "1" : "0");
+	root->add_child("ImagePrefetchDepth")->add_child_text (raw_convert<string> (_image_prefetch_depth));
+	root->add_child("ImagePrefetchThreads")->add_child_text (raw_convert<string> (_image_prefetch_threads));
+	root->add_child("UseExaminationCache")->add_child_text (_use_examination_cache ? "1" : "0");
+	if (_examination_cache_directory) {
+		root->add_child("ExaminationCacheDirectory")->add_child_text (_examination_cache_directory->string ());
+	}
 
 	for (vector<boost::filesystem::path>::const_iterator i = _history.begin(); i != _history.end(); ++i) {
 		root->add_child("History")->add_child_text (i->string ());
@@ -31,6 +31,7 @@
 #include "isdcf_metadata.h"
 #include "server.h"
 #include "video_content.h"
+#include "types.h"
 
 class ServerDescription;
 class Scaler;
@@ -204,6 +205,44 @@ public:
 		return _history;
 	}
 
+	bool detect_duplicate_frames () const {
+		return _detect_duplicate_frames;
+	}
+
+	/** @return memory that an encode may use to hold frames, in megabytes */
+	int memory_budget () const {
+		return _memory_budget;
+	}
+
+	/** @return maximum number of jobs which mostly use a given resource that may run at once */
+	int maximum_jobs (JobResource r) const {
+		return _maximum_jobs[r];
+	}
+
+	/** @return size of the buffer to use when reading content files, in kilobytes */
+	int content_read_buffer () const {
+		return _content_read_buffer;
+	}
+
+	bool content_read_ahead () const {
+		return _content_read_ahead;
+	}
+
+	/** @return number of files to read ahead of the current one in image sequences */
+	int image_prefetch_depth () const {
+		return _image_prefetch_depth;
+	}
+
+	/** @return number of image sequence files to read at the same time */
+	int image_prefetch_threads () const {
+		return _image_prefetch_threads;
+	}
+
+	/** @return true to remember the digests and examination results of content files */
+	bool use_examination_cache () const {
+		return _use_examination_cache;
+	}
+
 	/** @param n New number of local encoding threads */
 	void set_num_local_encoding_threads (int n) {
 		maybe_set (_num_local_encoding_threads, n);
@@ -350,6 +389,43 @@ public:
 		maybe_set (_log_types, t);
 	}
 
+	void set_detect_duplicate_frames (bool d) {
+		maybe_set (_detect_duplicate_frames, d);
+	}
+
+	void set_memory_budget (int m) {
+		maybe_set (_memory_budget, m);
+	}
+
+	void set_maximum_jobs (JobResource r, int n) {
+		maybe_set (_maximum_jobs[r], n);
+	}
+
+	void set_content_read_buffer (int b) {
+		maybe_set (_content_read_buffer, b);
+	}
+
+	void set_content_read_ahead (bool r) {
+		maybe_set (_content_read_ahead, r);
+	}
+
+	void set_image_prefetch_depth (int d) {
+		maybe_set (_image_prefetch_depth, d);
+	}
+
+	void set_image_prefetch_threads (int t) {
+		maybe_set (_image_prefetch_threads, t);
+	}
+
+	void set_use_examination_cache (bool u) {
+		maybe_set (_use_examination_cache, u);
+	}
+
+	/** @param d Directory to keep the examination cache in, instead of the usual one */
+	void set_examination_cache_directory (boost::filesystem::path d) {
+		maybe_set (_examination_cache_directory, boost::optional<boost::filesystem::path> (d));
+	}
+
 	void clear_history () {
 		_history.clear ();
 		changed ();
@@ -358,6 +434,7 @@ public:
 	void add_to_history (boost::filesystem::path p);
 
 	boost::filesystem::path signer_chain_directory () const;
+	boost::filesystem::path examination_cache_directory () const;
 
 	/** Set whether or not to write config changes to disk
 	 *  automatically.
@@ -441,6 +518,23 @@ private:
 	int _maximum_j2k_bandwidth;
 	int _log_types;
 	std::vector<boost::filesystem::path> _history;
+	/** true to look for identical consecutive frames in the source and encode them only once */
+	bool _detect_duplicate_frames;
+	/** memory that an encode may use to hold frames which are waiting to be encoded
+	    or written, in megabytes; beyond this, encoded frames are pushed to disk.
+	*/
+	int _memory_budget;
+	int _maximum_jobs[JOB_RESOURCE_COUNT];
+	/** size of the buffer to use when reading content files, in kilobytes */
+	int _content_read_buffer;
+	/** true to ask the operating system to read ahead in content files */
+	bool _content_read_ahead;
+	/** number of files to read ahead of the current one in image sequences; 0 to read none */
+	int _image_prefetch_depth;
+	int _image_prefetch_threads;
+	bool _use_examination_cache;
+	/** directory to keep the examination cache in, if not the default */
+	boost::optional<boost::filesystem::path> _examination_cache_directory;
 
 	bool _write_on_change;
 
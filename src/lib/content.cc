@@ -29,6 +29,7 @@
 #include "film.h"
 #include "safe_stringstream.h"
 #include "job.h"
+#include "examination_cache.h"
 
 #include "i18n.h"
 
@@ -39,6 +40,7 @@ using std::cout;
 using std::vector;
 using std::max;
 using boost::shared_ptr;
+using boost::optional;
 
 int const ContentProperty::PATH = 400;
 int const ContentProperty::POSITION = 401;
@@ -126,23 +128,30 @@ Content::as_xml (xmlpp::Node* node) const
 	node->add_child("TrimEnd")->add_child_text (raw_convert<string> (_trim_end));
 }
 
+/** @param job Job to report progress to, or 0 */
 void
 Content::examine (shared_ptr<Job> job)
 {
-	job->sub (_("Computing digest"));
+	if (job) {
+		job->sub (_("Computing digest"));
+	}
 
 	boost::mutex::scoped_lock lm (_mutex);
 	vector<boost::filesystem::path> p = _paths;
 	lm.unlock ();
 
-	/* Some content files are very big, so we use a poor man's
-	   digest here: a MD5 of the first and last 1e6 bytes with the
-	   size of the first file tacked on the end as a string.
-	*/
-	string const d = md5_digest_head_tail (p, 1000000) + raw_convert<string> (boost::filesystem::file_size (p.front ()));
+	optional<string> d = ExaminationCache::instance()->digest (p);
+	if (!d) {
+		/* Some content files are very big, so we use a poor man's
+		   digest here: a MD5 of the first and last 1e6 bytes with the
+		   size of the first file tacked on the end as a string.
+		*/
+		d = md5_digest_head_tail (p, 1000000) + raw_convert<string> (boost::filesystem::file_size (p.front ()));
+		ExaminationCache::instance()->set_digest (p, d.get ());
+	}
 
 	lm.lock ();
-	_digest = d;
+	_digest = d.get ();
 }
 
 void
@@ -18,13 +18,20 @@
 */
 
 #include <fstream>
+#include <vector>
+#include <cerrno>
+#include <cstring>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread.hpp>
 #include "cross.h"
 #include "compose.hpp"
 #include "log.h"
 #ifdef DCPOMATIC_LINUX
 #include <unistd.h>
 #include <mntent.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
 #endif
 #ifdef DCPOMATIC_WINDOWS
 #include <windows.h>
@@ -38,6 +45,9 @@
 #endif
 #ifdef DCPOMATIC_POSIX
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <ifaddrs.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -56,6 +66,8 @@ using std::ifstream;
 using std::string;
 using std::wstring;
 using std::make_pair;
+using std::min;
+using std::vector;
 using boost::shared_ptr;
 
 /** @param s Number of seconds to sleep for */
@@ -306,6 +318,371 @@ dcpomatic_fseek (FILE* stream, int64_t offset, int whence)
 #endif
 }
 
+/** Ask the filesystem to reserve space for a file to grow into, without changing its size.
+ *  This lets the file be laid out in a few large extents rather than many small ones
+ *  as it is written.
+ *  @param p File, which must exist.
+ *  @param size Number of bytes to reserve, counting from the start of the file.
+ *  @return true if the space was reserved.
+ */
+bool
+preallocate_file (boost::filesystem::path p, uint64_t size)
+{
+#if defined(DCPOMATIC_LINUX)
+	int const fd = open (p.c_str(), O_WRONLY);
+	if (fd < 0) {
+		return false;
+	}
+	bool const ok = fallocate (fd, FALLOC_FL_KEEP_SIZE, 0, size) == 0;
+	close (fd);
+	return ok;
+#elif defined(DCPOMATIC_OSX)
+	int const fd = open (p.c_str(), O_WRONLY);
+	if (fd < 0) {
+		return false;
+	}
+	fstore_t store;
+	store.fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL;
+	store.fst_posmode = F_PEOFPOSMODE;
+	store.fst_offset = 0;
+	store.fst_length = size;
+	store.fst_bytesalloc = 0;
+	if (fcntl (fd, F_PREALLOCATE, &store) == -1) {
+		/* Try again allowing a fragmented allocation */
+		store.fst_flags = F_ALLOCATEALL;
+		if (fcntl (fd, F_PREALLOCATE, &store) == -1) {
+			close (fd);
+			return false;
+		}
+	}
+	close (fd);
+	return true;
+#else
+	return false;
+#endif
+}
+
+/** Give back to the filesystem any space past the end of a file that was
+ *  reserved by preallocate_file() but not used.
+ *  @param p File.
+ */
+void
+release_preallocation (boost::filesystem::path p)
+{
+#if defined(DCPOMATIC_LINUX) || defined(DCPOMATIC_OSX)
+	int const fd = open (p.c_str(), O_WRONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	if (fstat (fd, &st) == 0) {
+		/* Truncating to the current size frees any blocks past the end of the file; hole-punching
+		   from the end of the file does not, at least on ext4.
+		*/
+		if (ftruncate (fd, st.st_size) != 0) {
+			/* There is nothing more that we can do */
+		}
+	}
+	close (fd);
+#endif
+}
+
+/** Tell the operating system that we are going to read a file sequentially,
+ *  and that it could start reading some of it now.
+ *  @param f File.
+ *  @param offset Offset in the file that we will read from next.
+ *  @param length Number of bytes from offset that could be read now.
+ */
+void
+read_ahead (FILE* f, int64_t offset, int64_t length)
+{
+#ifdef DCPOMATIC_LINUX
+	int const fd = fileno (f);
+	posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	posix_fadvise (fd, offset, length, POSIX_FADV_WILLNEED);
+#endif
+#ifdef DCPOMATIC_OSX
+	int const fd = fileno (f);
+	fcntl (fd, F_RDAHEAD, 1);
+	struct radvisory advice;
+	advice.ra_offset = offset;
+	advice.ra_count = length;
+	fcntl (fd, F_RDADVISE, &advice);
+#endif
+}
+
+/** @param p File.
+ *  @return A number which identifies the file on its filesystem (the inode number on POSIX systems,
+ *  the file index on Windows), or 0 if it cannot be found.
+ */
+uint64_t
+file_identity (boost::filesystem::path p)
+{
+#ifdef DCPOMATIC_POSIX
+	struct stat st;
+	if (stat (p.c_str(), &st) != 0) {
+		return 0;
+	}
+	return st.st_ino;
+#endif
+#ifdef DCPOMATIC_WINDOWS
+	HANDLE h = CreateFileW (p.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0);
+	if (h == INVALID_HANDLE_VALUE) {
+		return 0;
+	}
+	BY_HANDLE_FILE_INFORMATION info;
+	bool const ok = GetFileInformationByHandle (h, &info);
+	CloseHandle (h);
+	if (!ok) {
+		return 0;
+	}
+	return (uint64_t (info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+#endif
+}
+
+#ifdef DCPOMATIC_POSIX
+
+/** State shared between the threads of a chunked copy */
+struct ChunkedCopy
+{
+	ChunkedCopy (int f, int t, int64_t s)
+		: from (f)
+		, to (t)
+		, size (s)
+		, next (0)
+		, done (0)
+		, error (0)
+		, stop (false)
+	{}
+
+	int from;
+	int to;
+	int64_t size;
+	/** offset of the next chunk to be copied */
+	int64_t next;
+	/** number of bytes copied so far */
+	int64_t done;
+	/** errno of the first thing that went wrong, or 0 */
+	int error;
+	/** true if the copy should be abandoned */
+	bool stop;
+	boost::mutex mutex;
+};
+
+/** Copy chunks of a file until there are none left.
+ *  @param progress Progress callback, or an empty function.
+ */
+static void
+copy_chunks (ChunkedCopy* copy, boost::function<void (float)> progress)
+{
+	int64_t const chunk = 8 * 1024 * 1024;
+	vector<uint8_t> buffer (chunk);
+
+	while (true) {
+		boost::mutex::scoped_lock lm (copy->mutex);
+		if (copy->stop || copy->error || copy->next >= copy->size) {
+			return;
+		}
+		int64_t const offset = copy->next;
+		copy->next += chunk;
+		lm.unlock ();
+
+		int64_t const N = min (chunk, copy->size - offset);
+		int error = 0;
+
+		for (int64_t n = 0; n < N && !error; ) {
+			ssize_t const r = pread (copy->from, &buffer[n], N - n, offset + n);
+			if (r <= 0) {
+				error = r < 0 ? errno : EIO;
+			} else {
+				n += r;
+			}
+		}
+
+		for (int64_t n = 0; n < N && !error; ) {
+			ssize_t const r = pwrite (copy->to, &buffer[n], N - n, offset + n);
+			if (r <= 0) {
+				error = r < 0 ? errno : EIO;
+			} else {
+				n += r;
+			}
+		}
+
+		lm.lock ();
+		if (error) {
+			copy->error = error;
+			return;
+		}
+		copy->done += N;
+		float const p = float (copy->done) / copy->size;
+		lm.unlock ();
+
+		if (progress) {
+			progress (p);
+		}
+	}
+}
+
+/** Copy from one file descriptor to another.
+ *  @return 0 on success, otherwise errno.
+ */
+static int
+copy_file_descriptor (int from, int to, int64_t size, boost::function<void (float)> progress)
+{
+#ifdef FICLONE
+	/* Try a reflink, which shares the data between the two files and
+	   takes no time, on the filesystems that support it.
+	*/
+	if (ioctl (to, FICLONE, from) == 0) {
+		return 0;
+	}
+#endif
+
+#ifdef __NR_copy_file_range
+	/* Next try asking the kernel to do the copy, so the data need not come
+	   through user space (and may not even be read, on some filesystems).
+	*/
+	loff_t in_offset = 0;
+	loff_t out_offset = 0;
+	while (in_offset < size) {
+		ssize_t const r = syscall (
+			__NR_copy_file_range, from, &in_offset, to, &out_offset, size_t (min (size - in_offset, int64_t (256 * 1024 * 1024))), 0
+			);
+
+		if (r <= 0) {
+			if (in_offset == 0 && (r == 0 || errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+				/* Not supported here; fall back to copying it ourselves */
+				break;
+			}
+			return r < 0 ? errno : EIO;
+		}
+
+		if (progress) {
+			progress (float (in_offset) / size);
+		}
+	}
+
+	if (in_offset == size) {
+		return 0;
+	}
+#endif
+
+	/* Copy it ourselves, with a few threads so that we keep several reads and writes going */
+	if (ftruncate (to, size) != 0) {
+		return errno;
+	}
+
+	ChunkedCopy copy (from, to, size);
+	boost::thread_group helpers;
+	for (int i = 0; i < 3; ++i) {
+		helpers.create_thread (boost::bind (&copy_chunks, &copy, boost::function<void (float)> ()));
+	}
+
+	try {
+		copy_chunks (&copy, progress);
+	} catch (...) {
+		boost::mutex::scoped_lock lm (copy.mutex);
+		copy.stop = true;
+		lm.unlock ();
+		helpers.join_all ();
+		throw;
+	}
+
+	helpers.join_all ();
+	return copy.error;
+}
+
+#endif
+
+/** Copy a file as quickly as the platform allows.  This is much better than
+ *  boost::filesystem::copy_file for big files; on Linux we can often reflink,
+ *  or have the kernel do the copy, and otherwise the copy is done a chunk
+ *  at a time by several threads.  A FileError is thrown on failure, in which
+ *  case `to' will not exist.
+ *  @param progress Called (in the calling thread) with progress from 0 to 1.
+ */
+void
+dcpomatic_copy_file (boost::filesystem::path from, boost::filesystem::path to, boost::function<void (float)> progress)
+{
+	int64_t const size = boost::filesystem::file_size (from);
+	int error = 0;
+
+#ifdef DCPOMATIC_POSIX
+	int const from_fd = open (from.c_str(), O_RDONLY);
+	if (from_fd < 0) {
+		throw OpenFileError (from);
+	}
+
+	int const to_fd = open (to.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if (to_fd < 0) {
+		close (from_fd);
+		throw OpenFileError (to);
+	}
+
+	try {
+		error = copy_file_descriptor (from_fd, to_fd, size, progress);
+	} catch (...) {
+		close (from_fd);
+		close (to_fd);
+		boost::filesystem::remove (to);
+		throw;
+	}
+
+	close (from_fd);
+	if (close (to_fd) != 0 && !error) {
+		error = errno;
+	}
+#else
+	FILE* from_file = fopen_boost (from, "rb");
+	if (!from_file) {
+		throw OpenFileError (from);
+	}
+
+	FILE* to_file = fopen_boost (to, "wb");
+	if (!to_file) {
+		fclose (from_file);
+		throw OpenFileError (to);
+	}
+
+	int const chunk = 8 * 1024 * 1024;
+	vector<uint8_t> buffer (chunk);
+	int64_t done = 0;
+	try {
+		while (done < size) {
+			size_t const N = min (int64_t (chunk), size - done);
+			if (fread (&buffer[0], 1, N, from_file) != N) {
+				error = ferror (from_file) ? errno : EIO;
+				break;
+			}
+			if (fwrite (&buffer[0], 1, N, to_file) != N) {
+				error = errno;
+				break;
+			}
+			done += N;
+			if (progress) {
+				progress (float (done) / size);
+			}
+		}
+	} catch (...) {
+		fclose (from_file);
+		fclose (to_file);
+		boost::filesystem::remove (to);
+		throw;
+	}
+
+	fclose (from_file);
+	if (fclose (to_file) != 0 && !error) {
+		error = errno;
+	}
+#endif
+
+	if (error) {
+		boost::system::error_code ec;
+		boost::filesystem::remove (to, ec);
+		throw FileError (String::compose (_("could not copy file (%1)"), strerror (error)), from);
+	}
+}
+
 void
 Waker::nudge ()
 {
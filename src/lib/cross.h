@@ -21,6 +21,7 @@
 #define DCPOMATIC_CROSS_H
 
 #include <boost/filesystem.hpp>
+#include <boost/function.hpp>
 #ifdef DCPOMATIC_OSX
 #include <IOKit/pwr_mgt/IOPMLib.h>
 #endif
@@ -41,6 +42,11 @@ extern boost::filesystem::path app_contents ();
 #endif
 extern FILE * fopen_boost (boost::filesystem::path, std::string);
 extern int dcpomatic_fseek (FILE *, int64_t, int);
+extern bool preallocate_file (boost::filesystem::path, uint64_t);
+extern void release_preallocation (boost::filesystem::path);
+extern uint64_t file_identity (boost::filesystem::path);
+extern void read_ahead (FILE *, int64_t, int64_t);
+extern void dcpomatic_copy_file (boost::filesystem::path, boost::filesystem::path, boost::function<void (float)>);
 
 /** A class which tries to keep the computer awake on various operating systems.
  *  Create a Waker to prevent sleep, and call ::nudge every so often (every minute or so).
@@ -339,71 +339,18 @@ EncodedData::EncodedData (int s)
 
 }
 
-EncodedData::EncodedData (boost::filesystem::path file)
+EncodedData::EncodedData ()
+	: _data (0)
+	, _size (0)
 {
-	_size = boost::filesystem::file_size (file);
-	_data = new uint8_t[_size];
 
-	FILE* f = fopen_boost (file, "rb");
-	if (!f) {
-		throw FileError (_("could not open file for reading"), file);
-	}
-
-	size_t const r = fread (_data, 1, _size, f);
-	if (r != size_t (_size)) {
-		fclose (f);
-		throw FileError (_("could not read encoded data"), file);
-	}
-
-	fclose (f);
 }
 
-
 EncodedData::~EncodedData ()
 {
 	delete[] _data;
 }
 
-/** Write this data to a J2K file.
- *  @param Film Film.
- *  @param frame DCP frame index.
- */
-void
-EncodedData::write (shared_ptr<const Film> film, int frame, Eyes eyes) const
-{
-	boost::filesystem::path const tmp_j2c = film->j2c_path (frame, eyes, true);
-
-	FILE* f = fopen_boost (tmp_j2c, "wb");
-
-	if (!f) {
-		throw WriteFileError (tmp_j2c, errno);
-	}
-
-	fwrite (_data, 1, _size, f);
-	fclose (f);
-
-	boost::filesystem::path const real_j2c = film->j2c_path (frame, eyes, false);
-
-	/* Rename the file from foo.j2c.tmp to foo.j2c now that it is complete */
-	boost::filesystem::rename (tmp_j2c, real_j2c);
-}
-
-void
-EncodedData::write_info (shared_ptr<const Film> film, int frame, Eyes eyes, libdcp::FrameInfo info) const
-{
-	FILE* file = 0;
-	if (boost::filesystem::exists (film->info_file ())) {
-		file = fopen_boost (film->info_file(), "r+b");
-	} else {
-		file = fopen_boost (film->info_file(), "wb");
-	}
-	if (!file) {
-		throw OpenFileError (film->info_file ());
-	}
-	write_frame_info (file, frame, eyes, info);
-	fclose (file);
-}
-
 /** Send this data to a socket.
  *  @param socket Socket
  */
@@ -44,13 +44,9 @@ public:
 	/** @param s Size of data, in bytes */
 	EncodedData (int s);
 
-	EncodedData (boost::filesystem::path);
-
 	virtual ~EncodedData ();
 
 	void send (boost::shared_ptr<Socket> socket);
-	void write (boost::shared_ptr<const Film>, int, Eyes) const;
-	void write_info (boost::shared_ptr<const Film>, int, Eyes, libdcp::FrameInfo) const;
 
 	/** @return data */
 	uint8_t* data () const {
@@ -63,6 +59,9 @@ public:
 	}
 
 protected:
+	/** Constructor for subclasses which manage _data themselves */
+	EncodedData ();
+
 	uint8_t* _data; ///< data
 	int _size;	///< data size in bytes
 };
@@ -115,6 +114,10 @@ public:
 
 	Eyes eyes () const;
 
+	boost::shared_ptr<const PlayerVideoFrame> frame () const {
+		return _frame;
+	}
+
 private:
 
 	void add_metadata (xmlpp::Element *) const;
@@ -0,0 +1,232 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <vector>
+#include <algorithm>
+#include "encode_pool.h"
+#include "encoder.h"
+#include "dcp_video_frame.h"
+#include "server_finder.h"
+#include "config.h"
+#include "cross.h"
+
+using std::list;
+using std::vector;
+using std::string;
+using std::min;
+using std::sort;
+using boost::shared_ptr;
+using boost::optional;
+
+EncodePool* EncodePool::_instance = 0;
+
+EncodePool::EncodePool ()
+	: _work_generation (0)
+	, _thread_count (0)
+	, _local_thread_count (0)
+{
+	if (!ServerFinder::instance()->disabled ()) {
+		_server_found_connection = ServerFinder::instance()->connect (boost::bind (&EncodePool::server_found, this, _1));
+	}
+}
+
+/** Start encoding frames for an Encoder.  Our threads will call its pop_frame()
+ *  to look for work whenever they are free.
+ */
+void
+EncodePool::add (Encoder* encoder)
+{
+	boost::mutex::scoped_lock lm (_mutex);
+
+	/* Start any extra local threads that the configuration asks for; we never get rid of any */
+	while (_local_thread_count < Config::instance()->num_local_encoding_threads ()) {
+		_threads.create_thread (boost::bind (&EncodePool::thread, this, optional<ServerDescription> ()));
+		++_local_thread_count;
+		++_thread_count;
+	}
+
+	/* Start the new client off level with the least-served existing one, so that
+	   it does not take everything for itself until it has caught up.
+	*/
+	int64_t served = 0;
+	for (list<Client>::const_iterator i = _clients.begin(); i != _clients.end(); ++i) {
+		served = i == _clients.begin() ? i->served : min (served, i->served);
+	}
+
+	_clients.push_back (Client (encoder, served));
+}
+
+/** Stop encoding frames for an Encoder.  When this returns none of our threads
+ *  will be using the Encoder, though any frame that one had already taken from
+ *  it will have been passed back via frame_encoded() or frame_failed().
+ */
+void
+EncodePool::remove (Encoder* encoder)
+{
+	boost::mutex::scoped_lock lm (_mutex);
+
+	list<Client>::iterator i = _clients.begin ();
+	while (i != _clients.end() && i->encoder != encoder) {
+		++i;
+	}
+
+	if (i == _clients.end ()) {
+		return;
+	}
+
+	i->removing = true;
+	while (i->users > 0) {
+		_client_condition.wait (lm);
+	}
+
+	_clients.erase (i);
+}
+
+/** Called by an Encoder when it has put something in its queue */
+void
+EncodePool::work_available ()
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	++_work_generation;
+	_work_condition.notify_all ();
+}
+
+/** @return Total number of threads (local and remote) that we have */
+int
+EncodePool::threads () const
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	return _thread_count;
+}
+
+bool
+EncodePool::less_served (Client const * a, Client const * b)
+{
+	return a->served < b->served;
+}
+
+void
+EncodePool::thread (optional<ServerDescription> server)
+{
+	/* Number of seconds that we currently wait between attempts
+	   to connect to the server; not relevant for localhost
+	   encodings.
+	*/
+	int remote_backoff = 0;
+
+	boost::mutex::scoped_lock lm (_mutex);
+
+	while (true) {
+		/* Look at the clients who have had least from us first */
+		vector<Client*> order;
+		for (list<Client>::iterator i = _clients.begin(); i != _clients.end(); ++i) {
+			if (!i->removing) {
+				order.push_back (&(*i));
+				/* Stop this client going away while we are looking at it */
+				++i->users;
+			}
+		}
+		sort (order.begin(), order.end(), &EncodePool::less_served);
+
+		int64_t const generation = _work_generation;
+
+		Client* client = 0;
+		shared_ptr<DCPVideoFrame> vf;
+		for (vector<Client*>::iterator i = order.begin(); i != order.end(); ++i) {
+			if (!vf) {
+				lm.unlock ();
+				vf = (*i)->encoder->pop_frame ();
+				lm.lock ();
+				if (vf) {
+					client = *i;
+					++client->served;
+					continue;
+				}
+			}
+
+			--(*i)->users;
+			_client_condition.notify_all ();
+		}
+
+		if (!vf) {
+			/* Nobody has anything for us; wait for that to change, unless it already has */
+			if (generation == _work_generation) {
+				_work_condition.wait (lm);
+			}
+			continue;
+		}
+
+		lm.unlock ();
+
+		shared_ptr<EncodedData> encoded;
+		string error;
+
+		try {
+			if (server) {
+				encoded = vf->encode_remotely (server.get ());
+			} else {
+				encoded = vf->encode_locally ();
+			}
+		} catch (std::exception& e) {
+			error = e.what ();
+		}
+
+		if (encoded) {
+			/* This frame succeeded, so remove any backoff */
+			remote_backoff = 0;
+			client->encoder->frame_encoded (vf, encoded);
+		} else {
+			if (server && remote_backoff < 60) {
+				/* back off more */
+				remote_backoff += 10;
+			}
+			client->encoder->frame_failed (vf, server, error, remote_backoff);
+		}
+
+		lm.lock ();
+		--client->users;
+		_client_condition.notify_all ();
+
+		if (remote_backoff > 0) {
+			lm.unlock ();
+			dcpomatic_sleep (remote_backoff);
+			lm.lock ();
+		}
+	}
+}
+
+void
+EncodePool::server_found (ServerDescription s)
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	for (int i = 0; i < s.threads(); ++i) {
+		_threads.create_thread (boost::bind (&EncodePool::thread, this, s));
+		++_thread_count;
+	}
+}
+
+EncodePool*
+EncodePool::instance ()
+{
+	if (!_instance) {
+		_instance = new EncodePool ();
+	}
+
+	return _instance;
+}
@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef DCPOMATIC_ENCODE_POOL_H
+#define DCPOMATIC_ENCODE_POOL_H
+
+/** @file  src/lib/encode_pool.h
+ *  @brief EncodePool class.
+ */
+
+#include <list>
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/optional.hpp>
+#include <boost/signals2.hpp>
+#include <stdint.h>
+#include "server.h"
+
+class Encoder;
+
+/** @class EncodePool
+ *  @brief A process-wide set of threads which encode JPEG2000 frames, either locally
+ *  or on remote servers, for any number of Encoders at the same time.
+ *
+ *  Each Encoder keeps its own queue of frames; the pool's threads take frames from
+ *  those queues, sharing themselves out fairly between the Encoders that have work.
+ *  This means that one film's encode can start while another's is being finished off,
+ *  without either starting its own threads.
+ */
+class EncodePool : public boost::noncopyable
+{
+public:
+	void add (Encoder *);
+	void remove (Encoder *);
+	void work_available ();
+	int threads () const;
+
+	static EncodePool* instance ();
+
+private:
+	EncodePool ();
+
+	/** Something that we are encoding for */
+	struct Client
+	{
+		Client (Encoder* e, int64_t s)
+			: encoder (e)
+			, served (s)
+			, users (0)
+			, removing (false)
+		{}
+
+		Encoder* encoder;
+		/** number of frames that we have taken from this client */
+		int64_t served;
+		/** number of our threads that are using this client */
+		int users;
+		/** true if remove() is waiting for this client to be finished with */
+		bool removing;
+	};
+
+	void thread (boost::optional<ServerDescription>);
+	static bool less_served (Client const *, Client const *);
+	void server_found (ServerDescription);
+
+	/** mutex for everything below */
+	mutable boost::mutex _mutex;
+	/** condition to wake our threads when there might be something for them to do */
+	boost::condition _work_condition;
+	/** condition to signal that a Client's users count has gone down */
+	boost::condition _client_condition;
+	std::list<Client> _clients;
+	/** incremented whenever a client is given some more work to do */
+	int64_t _work_generation;
+	boost::thread_group _threads;
+	/** number of threads in _threads */
+	int _thread_count;
+	/** number of threads in _threads which encode locally */
+	int _local_thread_count;
+
+	boost::signals2::scoped_connection _server_found_connection;
+
+	static EncodePool* _instance;
+};
+
+#endif
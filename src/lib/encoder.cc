@@ -33,9 +33,11 @@
 #include "server.h"
 #include "cross.h"
 #include "writer.h"
-#include "server_finder.h"
+#include "encode_pool.h"
 #include "player.h"
 #include "player_video_frame.h"
+#include "black_frame_cache.h"
+#include "memory_budget.h"
 
 #include "i18n.h"
 
@@ -67,7 +69,16 @@ Encoder::Encoder (shared_ptr<const Film> f, weak_ptr<Job> j)
 	, _video_frames_out (0)
 	, _left_done (false)
 	, _right_done (false)
+	, _detect_duplicates (Config::instance()->detect_duplicate_frames ())
+	, _duplicates_found (0)
 	, _terminate (false)
+	, _queued_frame_bytes (0)
+	, _encoding (0)
+	, _threads (0)
+	, _in_pool (false)
+	, _pool_refused (false)
+	, _write_finish (false)
+	, _write_thread (0)
 {
 	_have_a_real_frame[EYES_BOTH] = false;
 	_have_a_real_frame[EYES_LEFT] = false;
@@ -76,37 +87,40 @@ Encoder::Encoder (shared_ptr<const Film> f, weak_ptr<Job> j)
 
 Encoder::~Encoder ()
 {
-	terminate_threads ();
+	terminate ();
 }
 
-/** Add a worker thread for a each thread on a remote server.  Caller must hold
- *  a lock on _mutex, or know that one is not currently required to
- *  safely modify _threads.
+/** Tell our Writer how many threads are encoding for us (and anybody else who is using
+ *  the EncodePool) if it has changed.  _mutex must be held.
  */
 void
-Encoder::add_worker_threads (ServerDescription d)
+Encoder::set_encoder_threads ()
 {
-	LOG_GENERAL (N_("Adding %1 worker threads for remote %2"), d.threads(), d.host_name ());
-	for (int i = 0; i < d.threads(); ++i) {
-		_threads.push_back (new boost::thread (boost::bind (&Encoder::encoder_thread, this, d)));
+	int const threads = EncodePool::instance()->threads ();
+	if (threads != _threads) {
+		LOG_GENERAL (N_("Encode pool now has %1 threads"), threads);
+		_threads = threads;
+		_writer->set_encoder_threads (_threads);
 	}
-
-	_writer->set_encoder_threads (_threads.size ());
 }
 
 void
 Encoder::process_begin ()
 {
-	for (int i = 0; i < Config::instance()->num_local_encoding_threads (); ++i) {
-		_threads.push_back (new boost::thread (boost::bind (&Encoder::encoder_thread, this, optional<ServerDescription> ())));
-	}
+	/* Frames in our queue are decoded, but not necessarily scaled, so this is a guess
+	   at their size: an RGB48 image of the DCP's size.
+	*/
+	_queued_frame_bytes = int64_t (_film->frame_size().width) * _film->frame_size().height * 6;
+	_memory.reset (new MemoryBudget (int64_t (Config::instance()->memory_budget ()) * 1024 * 1024));
 
-	_writer.reset (new Writer (_film, _job));
-	_writer->set_encoder_threads (_threads.size ());
+	_writer.reset (new Writer (_film, _job, _memory));
+	_write_thread = new boost::thread (boost::bind (&Encoder::write_thread, this));
 
-	if (!ServerFinder::instance()->disabled ()) {
-		_server_found_connection = ServerFinder::instance()->connect (boost::bind (&Encoder::server_found, this, _1));
-	}
+	EncodePool::instance()->add (this);
+
+	boost::mutex::scoped_lock lock (_mutex);
+	_in_pool = true;
+	set_encoder_threads ();
 }
 
 void
@@ -116,26 +130,19 @@ Encoder::process_end ()
 
 	LOG_GENERAL (N_("Clearing queue of %1"), _queue.size ());
 
-	/* Keep waking workers until the queue is empty */
-	while (!_queue.empty ()) {
-		_empty_condition.notify_all ();
+	/* Wait until the pool has encoded everything that we have given it */
+	while ((!_queue.empty () || _encoding > 0) && !_terminate) {
 		_full_condition.wait (lock);
 	}
 
 	lock.unlock ();
 
-	terminate_threads ();
+	terminate ();
 
-	LOG_GENERAL (N_("Mopping up %1"), _queue.size());
-
-	/* The following sequence of events can occur in the above code:
-	     1. a remote worker takes the last image off the queue
-	     2. the loop above terminates
-	     3. the remote worker fails to encode the image and puts it back on the queue
-	     4. the remote worker is then terminated by terminate_threads
-
-	     So just mop up anything left in the queue here.
+	/* There should be nothing left in the queue, but if there is (perhaps because
+	   we were terminated) encode it here.
 	*/
+	LOG_GENERAL (N_("Mopping up %1"), _queue.size());
 
 	for (list<shared_ptr<DCPVideoFrame> >::iterator i = _queue.begin(); i != _queue.end(); ++i) {
 		LOG_GENERAL (N_("Encode left-over frame %1"), (*i)->index ());
@@ -150,6 +157,18 @@ Encoder::process_end ()
 	_writer->finish ();
 	_writer.reset ();
 
+	if (_detect_duplicates) {
+		LOG_GENERAL (N_("Found %1 duplicate frames"), _duplicates_found);
+	}
+
+	LOG_GENERAL (
+		N_("Peak memory use by frames: %1MB waiting to be encoded, %2MB waiting to be written, %3MB in total (limit %4MB)"),
+		_memory->peak (MemoryBudget::ENCODER_QUEUE) / 1048576,
+		_memory->peak (MemoryBudget::WRITER_QUEUE) / 1048576,
+		_memory->peak () / 1048576,
+		_memory->limit () / 1048576
+		);
+
 	LOG_GENERAL_NC (N_("Encoder::process_end finished"));
 }
 
@@ -204,12 +223,44 @@ Encoder::process_video (shared_ptr<PlayerVideoFrame> pvf, bool same)
 
 	_waker.nudge ();
 
+	/* See if this frame is the same as the last one even though the player does not know it.
+	   We do this before taking the lock so that the encoder threads are not held up.  This
+	   is done on a single thread, so we first compare quick digests of part of each image,
+	   and only compute full digests when those match.
+	*/
+	bool duplicate = false;
+	if (_detect_duplicates && !same && !_writer->can_fake_write (_video_frames_out)) {
+		Eyes const e = pvf->eyes ();
+		string const q = pvf->quick_digest ();
+		if (_last_frame[e] && _last_quick_digest[e] && _last_quick_digest[e].get() == q) {
+			if (!_last_digest[e]) {
+				_last_digest[e] = _last_frame[e]->digest ();
+			}
+			string const d = pvf->digest ();
+			duplicate = _last_digest[e].get() == d;
+			_last_digest[e] = d;
+		} else {
+			_last_digest[e] = optional<string> ();
+		}
+		_last_frame[e] = pvf;
+		_last_quick_digest[e] = q;
+	}
+
 	boost::mutex::scoped_lock lock (_mutex);
 
 	/* XXX: discard 3D here if required */
 
-	/* Wait until the queue has gone down a bit */
-	while (_queue.size() >= _threads.size() * 2 && !_terminate) {
+	/* The pool may have found some more servers */
+	set_encoder_threads ();
+
+	/* Wait until the queue has gone down a bit.  We always allow enough frames to keep the
+	   encoder threads busy, and up to twice that if the memory budget allows.
+	*/
+	while (
+		int (_queue.size()) >= _threads &&
+		(int (_queue.size()) >= _threads * 2 || _memory->over (_queued_frame_bytes)) &&
+		!_terminate
+		) {
 		LOG_TIMING ("decoder sleeps with queue of %1", _queue.size());
 		_full_condition.wait (lock);
 		LOG_TIMING ("decoder wakes with queue of %1", _queue.size());
@@ -227,17 +278,36 @@ Encoder::process_video (shared_ptr<PlayerVideoFrame> pvf, bool same)
 	*/
 	rethrow ();
 
+	shared_ptr<const EncodedData> black;
+
 	if (_writer->can_fake_write (_video_frames_out)) {
 		_writer->fake_write (_video_frames_out, pvf->eyes ());
 		_have_a_real_frame[pvf->eyes()] = false;
+		_last_frame[pvf->eyes()].reset ();
+		_last_quick_digest[pvf->eyes()] = optional<string> ();
+		_last_digest[pvf->eyes()] = optional<string> ();
 		frame_done ();
-	} else if (same && _have_a_real_frame[pvf->eyes()]) {
+	} else if ((same || duplicate) && _have_a_real_frame[pvf->eyes()]) {
 		/* Use the last frame that we encoded. */
 		_writer->repeat (_video_frames_out, pvf->eyes());
+		if (duplicate) {
+			++_duplicates_found;
+		}
+		frame_done ();
+	} else if (
+		pvf->black () &&
+		(black = BlackFrameCache::instance()->get (pvf, _film->video_frame_rate(), _film->j2k_bandwidth(), _film->resolution(), _film->interop()))
+		) {
+		/* Black frames are all the same, so write one that was encoded before rather than using the encoder threads */
+		_writer->write (black, _video_frames_out, pvf->eyes ());
+		_have_a_real_frame[pvf->eyes()] = true;
 		frame_done ();
 	} else {
-		/* Queue this new frame for encoding */
+		/* Queue this new frame for encoding; if it is the first black frame of its kind
+		   write_thread() will give the result to the BlackFrameCache.
+		*/
 		LOG_TIMING ("adding to queue of %1", _queue.size ());
+		_memory->add (MemoryBudget::ENCODER_QUEUE, _queued_frame_bytes);
 		_queue.push_back (shared_ptr<DCPVideoFrame> (
 					  new DCPVideoFrame (
 						  pvf, _video_frames_out, _film->video_frame_rate(),
@@ -245,10 +315,8 @@ Encoder::process_video (shared_ptr<PlayerVideoFrame> pvf, bool same)
 						  )
 					  ));
 
-		/* The queue might not be empty any more, so notify anything which is
-		   waiting on that.
-		*/
-		_empty_condition.notify_all ();
+		/* The queue is not empty any more, so the pool can have it */
+		EncodePool::instance()->work_available ();
 		_have_a_real_frame[pvf->eyes()] = true;
 	}
 
@@ -282,116 +350,145 @@ Encoder::process_audio (shared_ptr<const AudioBuffers> data)
 	_writer->write (data);
 }
 
+/** Stop the EncodePool from taking any more frames from us, wait until
+ *  it is no longer using us, then wait for our write thread to give
+ *  the Writer everything that the pool has encoded.
+ */
 void
-Encoder::terminate_threads ()
+Encoder::terminate ()
 {
-	{
-		boost::mutex::scoped_lock lock (_mutex);
-		_terminate = true;
-		_full_condition.notify_all ();
-		_empty_condition.notify_all ();
+	boost::mutex::scoped_lock lock (_mutex);
+	_terminate = true;
+	_full_condition.notify_all ();
+	bool const in_pool = _in_pool;
+	_in_pool = false;
+	lock.unlock ();
+
+	if (in_pool) {
+		EncodePool::instance()->remove (this);
 	}
 
-	for (list<boost::thread *>::iterator i = _threads.begin(); i != _threads.end(); ++i) {
-		if ((*i)->joinable ()) {
-			(*i)->join ();
-		}
-		delete *i;
+	if (!_write_thread) {
+		return;
+	}
+
+	lock.lock ();
+	_write_finish = true;
+	_write_condition.notify_all ();
+	lock.unlock ();
+
+	_write_thread->join ();
+	delete _write_thread;
+	_write_thread = 0;
+}
+
+/** @return The next frame for the EncodePool to encode, or 0 if there is none */
+shared_ptr<DCPVideoFrame>
+Encoder::pop_frame ()
+{
+	boost::mutex::scoped_lock lock (_mutex);
+	if (_queue.empty () || _terminate) {
+		return shared_ptr<DCPVideoFrame> ();
+	}
+
+	if (!_encoded.empty() && int (_encoded.size()) >= _threads) {
+		/* Our Writer is not keeping up; let the pool do something for somebody else
+		   until it has caught up.
+		*/
+		_pool_refused = true;
+		return shared_ptr<DCPVideoFrame> ();
 	}
 
-	_threads.clear ();
+	shared_ptr<DCPVideoFrame> vf = _queue.front ();
+	LOG_TIMING ("[%1] encoder thread pops frame %2 (%3) from queue", boost::this_thread::get_id(), vf->index(), vf->eyes ());
+	_queue.pop_front ();
+	_memory->remove (MemoryBudget::ENCODER_QUEUE, _queued_frame_bytes);
+	++_encoding;
+
+	return vf;
 }
 
+/** Called by the EncodePool when it has encoded one of our frames.  The frame is
+ *  handed to our write thread, since the Writer may make us wait for it.
+ */
 void
-Encoder::encoder_thread (optional<ServerDescription> server)
-try
+Encoder::frame_encoded (shared_ptr<DCPVideoFrame> vf, shared_ptr<EncodedData> encoded)
 {
-	/* Number of seconds that we currently wait between attempts
-	   to connect to the server; not relevant for localhost
-	   encodings.
-	*/
-	int remote_backoff = 0;
+	boost::mutex::scoped_lock lock (_mutex);
+	_encoded.push_back (make_pair (vf, encoded));
+	_write_condition.notify_all ();
+}
 
+/** Thread to give frames that the EncodePool has encoded to our Writer */
+void
+Encoder::write_thread ()
+{
 	while (true) {
-
-		LOG_TIMING ("[%1] encoder thread sleeps", boost::this_thread::get_id());
 		boost::mutex::scoped_lock lock (_mutex);
-		while (_queue.empty () && !_terminate) {
-			_empty_condition.wait (lock);
+		while (_encoded.empty () && !_write_finish) {
+			_write_condition.wait (lock);
 		}
 
-		if (_terminate) {
-			LOG_TIMING ("[%1] encoder thread terminates", boost::this_thread::get_id());
-			return;
+		if (_encoded.empty ()) {
+			/* We've been asked to finish and there is nothing left to write */
+			break;
 		}
 
-		LOG_TIMING ("[%1] encoder thread wakes with queue of %2", boost::this_thread::get_id(), _queue.size());
-		shared_ptr<DCPVideoFrame> vf = _queue.front ();
-		LOG_TIMING ("[%1] encoder thread pops frame %2 (%3) from queue", boost::this_thread::get_id(), vf->index(), vf->eyes ());
-		_queue.pop_front ();
-
+		pair<shared_ptr<DCPVideoFrame>, shared_ptr<EncodedData> > f = _encoded.front ();
+		_encoded.pop_front ();
 		lock.unlock ();
 
-		shared_ptr<EncodedData> encoded;
-
-		if (server) {
-			try {
-				encoded = vf->encode_remotely (server.get ());
-
-				if (remote_backoff > 0) {
-					LOG_GENERAL ("%1 was lost, but now she is found; removing backoff", server->host_name ());
-				}
-
-				/* This job succeeded, so remove any backoff */
-				remote_backoff = 0;
-
-			} catch (std::exception& e) {
-				if (remote_backoff < 60) {
-					/* back off more */
-					remote_backoff += 10;
-				}
-				LOG_ERROR (
-					N_("Remote encode of %1 on %2 failed (%3); thread sleeping for %4s"),
-					vf->index(), server->host_name(), e.what(), remote_backoff
+		try {
+			_writer->write (f.second, f.first->index (), f.first->eyes ());
+			if (f.first->frame()->black ()) {
+				BlackFrameCache::instance()->add (
+					f.first->frame(), _film->video_frame_rate(), _film->j2k_bandwidth(), _film->resolution(), _film->interop(), f.second
 					);
 			}
-
-		} else {
-			try {
-				LOG_TIMING ("[%1] encoder thread begins local encode of %2", boost::this_thread::get_id(), vf->index());
-				encoded = vf->encode_locally ();
-				LOG_TIMING ("[%1] encoder thread finishes local encode of %2", boost::this_thread::get_id(), vf->index());
-			} catch (std::exception& e) {
-				LOG_ERROR (N_("Local encode failed (%1)"), e.what ());
-			}
-		}
-
-		if (encoded) {
-			_writer->write (encoded, vf->index (), vf->eyes ());
 			frame_done ();
-		} else {
-			lock.lock ();
-			LOG_GENERAL (N_("[%1] Encoder thread pushes frame %2 back onto queue after failure"), boost::this_thread::get_id(), vf->index());
-			_queue.push_front (vf);
-			lock.unlock ();
-		}
-
-		if (remote_backoff > 0) {
-			dcpomatic_sleep (remote_backoff);
+		} catch (...) {
+			store_current ();
 		}
 
-		/* The queue might not be full any more, so notify anything that is waiting on that */
 		lock.lock ();
+		--_encoding;
+		/* The queue might not be full any more, so notify anything that is waiting on that */
 		_full_condition.notify_all ();
+		bool const refused = _pool_refused;
+		_pool_refused = false;
+		lock.unlock ();
+
+		if (refused) {
+			/* There is room in _encoded again, so the pool can have some more frames */
+			EncodePool::instance()->work_available ();
+		}
 	}
 }
-catch (...)
-{
-	store_current ();
-}
 
+/** Called by the EncodePool when it failed to encode one of our frames.
+ *  @param server Server that the encode was tried on, or none for a local encode.
+ *  @param error Description of the error.
+ *  @param backoff Time in seconds for which the thread which tried will now sleep.
+ */
 void
-Encoder::server_found (ServerDescription s)
+Encoder::frame_failed (shared_ptr<DCPVideoFrame> vf, optional<ServerDescription> server, string error, int backoff)
 {
-	add_worker_threads (s);
+	if (server) {
+		LOG_ERROR (
+			N_("Remote encode of %1 on %2 failed (%3); thread sleeping for %4s"),
+			vf->index(), server->host_name(), error, backoff
+			);
+	} else {
+		LOG_ERROR (N_("Local encode failed (%1)"), error);
+	}
+
+	boost::mutex::scoped_lock lock (_mutex);
+	LOG_GENERAL (N_("[%1] Encoder thread pushes frame %2 back onto queue after failure"), boost::this_thread::get_id(), vf->index());
+	_queue.push_front (vf);
+	_memory->add (MemoryBudget::ENCODER_QUEUE, _queued_frame_bytes);
+	--_encoding;
+	_full_condition.notify_all ();
+	lock.unlock ();
+
+	EncodePool::instance()->work_available ();
 }
@@ -47,14 +47,15 @@ class DCPVideoFrame;
 class EncodedData;
 class Writer;
 class Job;
-class ServerFinder;
 class PlayerVideoFrame;
+class MemoryBudget;
 
 /** @class Encoder
  *  @brief Encoder to J2K and WAV for DCP.
  *
  *  Video is supplied to process_video as RGB frames, and audio
  *  is supplied as uncompressed PCM in blocks of various sizes.
+ *  The JPEG2000 encoding is done by the process-wide EncodePool.
  */
 
 class Encoder : public boost::noncopyable, public ExceptionStore
@@ -81,14 +82,17 @@ public:
 	float current_encoding_rate () const;
 	int video_frames_out () const;
 
+	/* These are called by EncodePool's threads */
+	boost::shared_ptr<DCPVideoFrame> pop_frame ();
+	void frame_encoded (boost::shared_ptr<DCPVideoFrame>, boost::shared_ptr<EncodedData>);
+	void frame_failed (boost::shared_ptr<DCPVideoFrame>, boost::optional<ServerDescription>, std::string, int);
+
 private:
 
 	void frame_done ();
-
-	void encoder_thread (boost::optional<ServerDescription>);
-	void terminate_threads ();
-	void add_worker_threads (ServerDescription);
-	void server_found (ServerDescription);
+	void terminate ();
+	void write_thread ();
+	void set_encoder_threads ();
 
 	/** Film that we are encoding */
 	boost::shared_ptr<const Film> _film;
@@ -109,19 +113,46 @@ private:
 	bool _right_done;
 
 	bool _have_a_real_frame[EYES_COUNT];
+	/** true to look for frames which are identical to the one before and REPEAT-write them */
+	bool _detect_duplicates;
+	/** last frame that we were given for each eye, if we are looking for duplicates */
+	boost::shared_ptr<PlayerVideoFrame> _last_frame[EYES_COUNT];
+	/** quick digest of _last_frame, if we know it */
+	boost::optional<std::string> _last_quick_digest[EYES_COUNT];
+	/** full digest of _last_frame, if we have needed it */
+	boost::optional<std::string> _last_digest[EYES_COUNT];
+	/** number of duplicate frames found by comparing digests */
+	int _duplicates_found;
 	bool _terminate;
+	/** frames waiting to be taken by the EncodePool */
 	std::list<boost::shared_ptr<DCPVideoFrame> > _queue;
-	std::list<boost::thread *> _threads;
+	/** memory that we account for each frame in _queue, in bytes (an estimate) */
+	int64_t _queued_frame_bytes;
+	/** number of frames that the EncodePool has taken from _queue which have not been given back or written */
+	int _encoding;
+	/** number of threads in the EncodePool the last time we looked */
+	int _threads;
+	/** true if we have been added to the EncodePool */
+	bool _in_pool;
+	/** frames which the EncodePool has encoded, waiting for _write_thread to give them to _writer */
+	std::list<std::pair<boost::shared_ptr<DCPVideoFrame>, boost::shared_ptr<EncodedData> > > _encoded;
+	/** true if pop_frame() has turned the EncodePool away because _encoded was full */
+	bool _pool_refused;
+	/** true to ask _write_thread to finish once _encoded is empty */
+	bool _write_finish;
+	/** condition to wake _write_thread when there is something in _encoded */
+	boost::condition _write_condition;
 	mutable boost::mutex _mutex;
-	/** condition to manage thread wakeups when we have nothing to do */
-	boost::condition _empty_condition;
 	/** condition to manage thread wakeups when we have too much to do */
 	boost::condition _full_condition;
 
+	/** account of the memory used by frames in our queue and our Writer's */
+	boost::shared_ptr<MemoryBudget> _memory;
 	boost::shared_ptr<Writer> _writer;
+	/** thread which gives encoded frames to _writer, so that the EncodePool's threads
+	    never wait for it */
+	boost::thread* _write_thread;
 	Waker _waker;
-
-	boost::signals2::scoped_connection _server_found_connection;
 };
 
 #endif
@@ -0,0 +1,263 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <ctime>
+#include <algorithm>
+#include <libxml++/libxml++.h>
+#include <libcxml/cxml.h>
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+#include "examination_cache.h"
+#include "md5_digester.h"
+#include "config.h"
+#include "cross.h"
+#include "version.h"
+#include "compose.hpp"
+
+using std::string;
+using std::vector;
+using std::pair;
+using std::make_pair;
+using std::sort;
+using boost::shared_ptr;
+using boost::optional;
+
+ExaminationCache* ExaminationCache::_instance = 0;
+boost::mutex ExaminationCache::_instance_mutex;
+
+/** Version of the format of the things that we store; changing this means that no existing entries will be used */
+static int const cache_version = 2;
+/** Number of files in the cache above which we remove the least recently used */
+static size_t const max_files = 8192;
+
+ExaminationCache::ExaminationCache ()
+	: _directory (Config::instance()->examination_cache_directory ())
+{
+	prune ();
+}
+
+/** @return Key for a set of content files, or an empty optional if any of them could not be found */
+optional<string>
+ExaminationCache::key (vector<boost::filesystem::path> const & paths) const
+{
+	MD5Digester digester;
+	digester.add (cache_version);
+
+	/* What we store comes from our examiners and FFmpeg, so nothing that was found by a
+	   different build of either is used; that way a fix to how content is examined takes
+	   effect without anybody having to remember to change cache_version.
+	*/
+	string const build = String::compose ("%1 %2", dcpomatic_version, dcpomatic_git_commit);
+	digester.add (build.c_str(), build.length ());
+	digester.add (avformat_version ());
+	digester.add (avcodec_version ());
+
+	for (vector<boost::filesystem::path>::const_iterator i = paths.begin(); i != paths.end(); ++i) {
+		boost::system::error_code ec;
+		boost::filesystem::path const p = boost::filesystem::absolute (*i);
+
+		boost::uintmax_t const size = boost::filesystem::file_size (p, ec);
+		if (ec) {
+			return optional<string> ();
+		}
+
+		std::time_t const mtime = boost::filesystem::last_write_time (p, ec);
+		if (ec) {
+			return optional<string> ();
+		}
+
+		string const s = p.string ();
+		digester.add (s.length ());
+		digester.add (s.c_str(), s.length ());
+		digester.add (size);
+		digester.add (mtime);
+		digester.add (file_identity (p));
+	}
+
+	return digester.get ();
+}
+
+/** @return Cache file for some content files, or an empty optional if the cache is
+ *  turned off or the files could not be found.
+ */
+optional<boost::filesystem::path>
+ExaminationCache::file (vector<boost::filesystem::path> const & paths, string extension) const
+{
+	if (!Config::instance()->use_examination_cache ()) {
+		return optional<boost::filesystem::path> ();
+	}
+
+	optional<string> k = key (paths);
+	if (!k) {
+		return optional<boost::filesystem::path> ();
+	}
+
+	return _directory / (k.get() + extension);
+}
+
+/** Mark a cache file as having just been used, so that it is kept in preference to others */
+static void
+touch (boost::filesystem::path p)
+{
+	boost::system::error_code ec;
+	boost::filesystem::last_write_time (p, std::time (0), ec);
+}
+
+/** @return The digest of some content files, if we know it */
+optional<string>
+ExaminationCache::digest (vector<boost::filesystem::path> const & paths)
+{
+	optional<boost::filesystem::path> f = file (paths, ".digest");
+	if (!f || !boost::filesystem::exists (f.get ())) {
+		return optional<string> ();
+	}
+
+	FILE* d = fopen_boost (f.get(), "r");
+	if (!d) {
+		return optional<string> ();
+	}
+
+	char buffer[256];
+	optional<string> r;
+	if (fgets (buffer, sizeof (buffer), d) && buffer[0] != '\0') {
+		r = string (buffer);
+	}
+	fclose (d);
+
+	touch (f.get ());
+	return r;
+}
+
+void
+ExaminationCache::set_digest (vector<boost::filesystem::path> const & paths, string digest)
+{
+	optional<boost::filesystem::path> f = file (paths, ".digest");
+	if (!f) {
+		return;
+	}
+
+	boost::mutex::scoped_lock lm (_mutex);
+
+	/* Write to a temporary file and then move it into place so that nobody
+	   ever sees a partly-written entry.
+	*/
+	boost::filesystem::path tmp = f.get().string() + ".tmp";
+
+	FILE* d = fopen_boost (tmp, "w");
+	if (!d) {
+		return;
+	}
+	fputs (digest.c_str(), d);
+	fclose (d);
+
+	boost::system::error_code ec;
+	boost::filesystem::rename (tmp, f.get (), ec);
+}
+
+/** @return The examination results that were stored for some content files,
+ *  or 0 if there are none.
+ */
+shared_ptr<cxml::Document>
+ExaminationCache::examination (vector<boost::filesystem::path> const & paths)
+{
+	optional<boost::filesystem::path> f = file (paths, ".xml");
+	if (!f || !boost::filesystem::exists (f.get ())) {
+		return shared_ptr<cxml::Document> ();
+	}
+
+	shared_ptr<cxml::Document> doc (new cxml::Document ("Examination"));
+	try {
+		doc->read_file (f.get ());
+	} catch (std::exception& e) {
+		/* Something is wrong with this entry; just ignore it */
+		return shared_ptr<cxml::Document> ();
+	}
+
+	touch (f.get ());
+	return doc;
+}
+
+/** @param examination Document whose root node is called Examination */
+void
+ExaminationCache::set_examination (vector<boost::filesystem::path> const & paths, shared_ptr<xmlpp::Document> examination)
+{
+	optional<boost::filesystem::path> f = file (paths, ".xml");
+	if (!f) {
+		return;
+	}
+
+	boost::mutex::scoped_lock lm (_mutex);
+
+	boost::filesystem::path tmp = f.get().string() + ".tmp";
+
+	try {
+		examination->write_to_file_formatted (tmp.string ());
+	} catch (std::exception& e) {
+		/* Not being able to write to the cache does not matter much */
+		return;
+	}
+
+	boost::system::error_code ec;
+	boost::filesystem::rename (tmp, f.get (), ec);
+}
+
+/** Remove the least recently used entries if there are too many */
+void
+ExaminationCache::prune ()
+{
+	boost::mutex::scoped_lock lm (_mutex);
+
+	vector<pair<std::time_t, boost::filesystem::path> > files;
+
+	boost::system::error_code ec;
+	for (boost::filesystem::directory_iterator i (_directory, ec); i != boost::filesystem::directory_iterator(); i.increment (ec)) {
+		if (ec) {
+			return;
+		}
+		if (i->path().extension() == ".tmp") {
+			/* Left over from something that went wrong */
+			boost::filesystem::remove (i->path (), ec);
+			continue;
+		}
+		files.push_back (make_pair (boost::filesystem::last_write_time (i->path (), ec), i->path ()));
+	}
+
+	if (files.size() <= max_files) {
+		return;
+	}
+
+	sort (files.begin(), files.end ());
+	for (size_t i = 0; i < files.size() - max_files; ++i) {
+		boost::filesystem::remove (files[i].second, ec);
+	}
+}
+
+ExaminationCache*
+ExaminationCache::instance ()
+{
+	/* We can be called from several examination threads at once */
+	boost::mutex::scoped_lock lm (_instance_mutex);
+	if (!_instance) {
+		_instance = new ExaminationCache ();
+	}
+
+	return _instance;
+}
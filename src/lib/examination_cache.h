@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef DCPOMATIC_EXAMINATION_CACHE_H
+#define DCPOMATIC_EXAMINATION_CACHE_H
+
+/** @file  src/lib/examination_cache.h
+ *  @brief ExaminationCache class.
+ */
+
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace cxml {
+	class Document;
+}
+
+namespace xmlpp {
+	class Document;
+}
+
+/** @class ExaminationCache
+ *  @brief An on-disk store of the digests and examination results of content files.
+ *
+ *  Entries are keyed on the path, size, modification time and filesystem identity
+ *  (e.g. inode) of each file in a piece of content, so that if the same files are
+ *  added again (to this film or any other) they need not be read.  Any change to
+ *  the files gives a different key, so stale entries are never used; they are
+ *  removed when the cache grows too big.  Keys also include the DCP-o-matic build
+ *  and FFmpeg versions, so that entries made by other builds are not used either.
+ *
+ *  The cache does nothing if Config::use_examination_cache() is false.
+ */
+class ExaminationCache : public boost::noncopyable
+{
+public:
+	boost::optional<std::string> digest (std::vector<boost::filesystem::path> const & paths);
+	void set_digest (std::vector<boost::filesystem::path> const & paths, std::string digest);
+
+	boost::shared_ptr<cxml::Document> examination (std::vector<boost::filesystem::path> const & paths);
+	void set_examination (std::vector<boost::filesystem::path> const & paths, boost::shared_ptr<xmlpp::Document> examination);
+
+	static ExaminationCache* instance ();
+
+private:
+	ExaminationCache ();
+
+	boost::optional<std::string> key (std::vector<boost::filesystem::path> const & paths) const;
+	boost::optional<boost::filesystem::path> file (std::vector<boost::filesystem::path> const & paths, std::string extension) const;
+	void prune ();
+
+	/** mutex to serialise our changes to the cache directory */
+	boost::mutex _mutex;
+	boost::filesystem::path _directory;
+
+	static ExaminationCache* _instance;
+	static boost::mutex _instance_mutex;
+};
+
+#endif
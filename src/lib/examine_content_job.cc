@@ -22,16 +22,23 @@
 #include "log.h"
 #include "content.h"
 #include "film.h"
+#include "config.h"
+#include "exceptions.h"
 
 #include "i18n.h"
 
 using std::string;
 using std::cout;
+using std::min;
+using std::max;
 using boost::shared_ptr;
 
-ExamineContentJob::ExamineContentJob (shared_ptr<const Film> f, shared_ptr<Content> c)
+ExamineContentJob::ExamineContentJob (shared_ptr<const Film> f, ContentList c)
 	: Job (f)
 	, _content (c)
+	, _next (0)
+	, _done (0)
+	, _errors (c.size ())
 {
 
 }
@@ -56,7 +63,104 @@ ExamineContentJob::json_name () const
 void
 ExamineContentJob::run ()
 {
-	_content->examine (shared_from_this ());
+	if (_content.size() == 1) {
+		/* Only one thing to do, so it can tell us how it is getting on */
+		_content.front()->examine (shared_from_this ());
+		boost::mutex::scoped_lock lm (_mutex);
+		_examined = _content;
+		lm.unlock ();
+		set_progress (1);
+		set_state (FINISHED_OK);
+		return;
+	}
+
+	int const threads = min (int (_content.size ()), max (1, Config::instance()->num_local_encoding_threads ()));
+
+	boost::thread_group group;
+	for (int i = 0; i < threads; ++i) {
+		group.create_thread (boost::bind (&ExamineContentJob::examine_thread, this));
+	}
+
+	try {
+		while (true) {
+			boost::mutex::scoped_lock lm (_mutex);
+			if (_done == _content.size ()) {
+				break;
+			}
+			_condition.timed_wait (lm, boost::posix_time::milliseconds (250));
+			float const progress = float (_done) / _content.size ();
+			lm.unlock ();
+
+			set_progress (progress);
+		}
+	} catch (...) {
+		/* Don't start examining anything else, and wait for what has been started */
+		boost::mutex::scoped_lock lm (_mutex);
+		_next = _content.size ();
+		lm.unlock ();
+		group.join_all ();
+		throw;
+	}
+
+	group.join_all ();
+
+	/* Keep the order that we were given, whatever order things finished in */
+	string errors;
+	boost::mutex::scoped_lock lm (_mutex);
+	for (size_t i = 0; i < _content.size(); ++i) {
+		if (_errors[i].empty ()) {
+			_examined.push_back (_content[i]);
+		} else {
+			errors += String::compose ("%1: %2\n", _content[i]->path_summary (), _errors[i]);
+		}
+	}
+	lm.unlock ();
+
+	if (!errors.empty ()) {
+		/* What was examined OK will still be added */
+		throw StringError (String::compose (_("Some content could not be examined:\n%1"), errors));
+	}
+
 	set_progress (1);
 	set_state (FINISHED_OK);
 }
+
+/** Thread to examine pieces of content until there are none left */
+void
+ExamineContentJob::examine_thread ()
+{
+	while (true) {
+		boost::mutex::scoped_lock lm (_mutex);
+		if (_next >= _content.size ()) {
+			return;
+		}
+		size_t const index = _next++;
+		lm.unlock ();
+
+		string error;
+		try {
+			/* There are several of us, so don't let the content report its progress */
+			_content[index]->examine (shared_ptr<Job> ());
+		} catch (std::exception& e) {
+			error = e.what ();
+			if (error.empty ()) {
+				error = _("unknown error");
+			}
+		} catch (...) {
+			error = _("unknown error");
+		}
+
+		lm.lock ();
+		_errors[index] = error;
+		++_done;
+		_condition.notify_all ();
+	}
+}
+
+/** @return The content that was examined successfully, in the order that it was given to us */
+ContentList
+ExamineContentJob::examined () const
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	return _examined;
+}
@@ -17,23 +17,50 @@
 
 */
 
+#include <vector>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
 #include "job.h"
+#include "types.h"
 
 class Content;
 class Log;
 
+/** @class ExamineContentJob
+ *  @brief A job to examine some pieces of content.  If there is more than one
+ *  they are examined in parallel.
+ */
 class ExamineContentJob : public Job
 {
 public:
-	ExamineContentJob (boost::shared_ptr<const Film>, boost::shared_ptr<Content>);
+	ExamineContentJob (boost::shared_ptr<const Film>, ContentList);
 	~ExamineContentJob ();
 
 	std::string name () const;
 	std::string json_name () const;
 	void run ();
 
+	JobResource resource () const {
+		return JOB_RESOURCE_DISK;
+	}
+
+	ContentList examined () const;
+
 private:
-	boost::shared_ptr<Content> _content;
-};
+	void examine_thread ();
 
+	ContentList _content;
+
+	/** mutex for everything below */
+	mutable boost::mutex _mutex;
+	/** condition to signal that some content has been examined */
+	boost::condition _condition;
+	/** index into _content of the next thing to examine */
+	size_t _next;
+	/** number of pieces of content that have been examined (successfully or not) */
+	size_t _done;
+	/** error from examining each piece of content, or empty if it went OK */
+	std::vector<std::string> _errors;
+	/** content that was examined successfully, in the same order as _content */
+	ContentList _examined;
+};
@@ -28,6 +28,7 @@ extern "C" {
 #include "ffmpeg_content.h"
 #include "exceptions.h"
 #include "util.h"
+#include "config.h"
 
 #include "i18n.h"
 
@@ -35,17 +36,19 @@ using std::string;
 using std::cout;
 using std::set;
 using boost::shared_ptr;
+using boost::optional;
 
 boost::mutex FFmpeg::_mutex;
 
 FFmpeg::FFmpeg (boost::shared_ptr<const FFmpegContent> c)
 	: _ffmpeg_content (c)
 	, _avio_buffer (0)
-	, _avio_buffer_size (4096)
+	, _avio_buffer_size (Config::instance()->content_read_buffer() * 1024)
 	, _avio_context (0)
 	, _format_context (0)
 	, _frame (0)
 	, _video_stream (-1)
+	, _probe_duration (0)
 {
 	setup_general ();
 	setup_video ();
@@ -80,32 +83,109 @@ avio_seek_wrapper (void* data, int64_t offset, int whence)
 	return reinterpret_cast<FFmpeg*>(data)->avio_seek (offset, whence);
 }
 
+/** Durations (in microseconds) of content that we will look through to find stream information,
+ *  in the order that we try them.
+ */
+static int64_t const probe_durations[] = {
+	5 * 1000000,
+	30 * 1000000,
+	5 * 60 * 1000000
+};
+
+static int const probe_durations_count = sizeof (probe_durations) / sizeof (probe_durations[0]);
+
+/** Open _format_context and find its streams.
+ *  @param duration Duration in microseconds of how far into the content file we will
+ *  look for stream information; we will also read at most this many bytes.
+ */
+void
+FFmpeg::open_input (int64_t duration)
+{
+	AVDictionary* options = 0;
+	av_dict_set (&options, "analyzeduration", raw_convert<string> (duration).c_str(), 0);
+	av_dict_set (&options, "probesize", raw_convert<string> (duration).c_str(), 0);
+
+	int const r = avformat_open_input (&_format_context, 0, 0, &options);
+	av_dict_free (&options);
+	if (r < 0) {
+		throw OpenFileError (_ffmpeg_content->path(0).string ());
+	}
+
+	if (avformat_find_stream_info (_format_context, 0) < 0) {
+		throw DecodeError (_("could not find stream information"));
+	}
+}
+
+/** @return true if avformat_find_stream_info has found everything that we need to know
+ *  about the video and audio streams in _format_context.
+ */
+bool
+FFmpeg::stream_parameters_known () const
+{
+	bool video = false;
+
+	for (uint32_t i = 0; i < _format_context->nb_streams; ++i) {
+		AVCodecContext* context = _format_context->streams[i]->codec;
+		switch (context->codec_type) {
+		case AVMEDIA_TYPE_VIDEO:
+			if (context->width == 0 || context->height == 0 || context->pix_fmt == PIX_FMT_NONE) {
+				return false;
+			}
+			video = true;
+			break;
+		case AVMEDIA_TYPE_AUDIO:
+			if (context->sample_rate == 0 || context->channels == 0 || context->sample_fmt == AV_SAMPLE_FMT_NONE) {
+				return false;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return video;
+}
+
 void
 FFmpeg::setup_general ()
 {
 	av_register_all ();
 
 	_file_group.set_paths (_ffmpeg_content->paths ());
+	_file_group.set_read_ahead (Config::instance()->content_read_ahead ());
 	_avio_buffer = static_cast<uint8_t*> (wrapped_av_malloc (_avio_buffer_size));
 	_avio_context = avio_alloc_context (_avio_buffer, _avio_buffer_size, 0, this, avio_read_wrapper, 0, avio_seek_wrapper);
 	_format_context = avformat_alloc_context ();
 	_format_context->pb = _avio_context;
 
-	AVDictionary* options = 0;
-	/* These durations are in microseconds, and represent how far into the content file
-	   we will look for streams.
+	/* Look a little way into the content file for stream information to start with,
+	   and further only if that does not tell us everything that we need.  If the
+	   content has been examined before we already know how far we need to look.
 	*/
-	av_dict_set (&options, "analyzeduration", raw_convert<string> (5 * 60 * 1000000).c_str(), 0);
-	av_dict_set (&options, "probesize", raw_convert<string> (5 * 60 * 1000000).c_str(), 0);
-
-	if (avformat_open_input (&_format_context, 0, 0, &options) < 0) {
-		throw OpenFileError (_ffmpeg_content->path(0).string ());
+	optional<int64_t> known = _ffmpeg_content->probe_duration ();
+	int probe = 0;
+	if (known) {
+		while (probe < (probe_durations_count - 1) && probe_durations[probe] < known.get ()) {
+			++probe;
+		}
 	}
 
-	if (avformat_find_stream_info (_format_context, 0) < 0) {
-		throw DecodeError (_("could not find stream information"));
+	while (true) {
+		open_input (probe_durations[probe]);
+		if (probe == (probe_durations_count - 1) || stream_parameters_known ()) {
+			break;
+		}
+
+		/* Start again, looking further this time */
+		avformat_close_input (&_format_context);
+		::avio_seek (_avio_context, 0, SEEK_SET);
+		_format_context = avformat_alloc_context ();
+		_format_context->pb = _avio_context;
+		++probe;
 	}
 
+	_probe_duration = probe_durations[probe];
+
 	/* Find video stream */
 
 	int video_stream_undefined_frame_rate = -1;
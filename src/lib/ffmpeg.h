@@ -53,6 +53,13 @@ public:
 	int avio_read (uint8_t *, int);
 	int64_t avio_seek (int64_t, int);
 
+	/** @return Duration in microseconds of content that we had to look at
+	 *  to find out about all our streams.
+	 */
+	int64_t probe_duration () const {
+		return _probe_duration;
+	}
+
 protected:
 	AVCodecContext* video_codec_context () const;
 
@@ -69,6 +76,7 @@ protected:
 
 	/** Index of video stream within AVFormatContext */
 	int _video_stream;
+	int64_t _probe_duration;
 
 	/* It would appear (though not completely verified) that one must have
 	   a mutex around calls to avcodec_open* and avcodec_close... and here
@@ -78,6 +86,8 @@ protected:
 
 private:
 	void setup_general ();
+	void open_input (int64_t);
+	bool stream_parameters_known () const;
 	void setup_video ();
 	void setup_audio ();
 };
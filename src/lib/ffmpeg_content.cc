@@ -22,6 +22,7 @@ extern "C" {
 #include <libavformat/avformat.h>
 }
 #include <libcxml/cxml.h>
+#include <libxml++/libxml++.h>
 #include "raw_convert.h"
 #include "ffmpeg_content.h"
 #include "ffmpeg_examiner.h"
@@ -34,6 +35,7 @@ extern "C" {
 #include "exceptions.h"
 #include "frame_rate_change.h"
 #include "safe_stringstream.h"
+#include "examination_cache.h"
 
 #include "i18n.h"
 
@@ -48,6 +50,7 @@ using std::back_inserter;
 using std::max;
 using boost::shared_ptr;
 using boost::dynamic_pointer_cast;
+using boost::optional;
 
 int const FFmpegContentProperty::SUBTITLE_STREAMS = 100;
 int const FFmpegContentProperty::SUBTITLE_STREAM = 101;
@@ -104,6 +107,7 @@ FFmpegContent::FFmpegContent (shared_ptr<const Film> f, shared_ptr<const cxml::N
 	}
 
 	_first_video = node->optional_number_child<double> ("FirstVideo");
+	_probe_duration = node->optional_number_child<int64_t> ("ProbeDuration");
 }
 
 FFmpegContent::FFmpegContent (shared_ptr<const Film> f, vector<boost::shared_ptr<Content> > c)
@@ -126,6 +130,7 @@ FFmpegContent::FFmpegContent (shared_ptr<const Film> f, vector<boost::shared_ptr
 	_subtitle_stream = ref->subtitle_stream ();
 	_audio_streams = ref->ffmpeg_audio_streams ();
 	_first_video = ref->_first_video;
+	_probe_duration = ref->_probe_duration;
 }
 
 void
@@ -158,22 +163,158 @@ FFmpegContent::as_xml (xmlpp::Node* node) const
 	if (_first_video) {
 		node->add_child("FirstVideo")->add_child_text (raw_convert<string> (_first_video.get ()));
 	}
+
+	if (_probe_duration) {
+		node->add_child("ProbeDuration")->add_child_text (raw_convert<string> (_probe_duration.get ()));
+	}
 }
 
+/** @class CachedFFmpegExamination
+ *  @brief The results of an FFmpegExaminer, read back from the ExaminationCache.
+ */
+class CachedFFmpegExamination : public VideoExaminer
+{
+public:
+	CachedFFmpegExamination (shared_ptr<const cxml::Node> node)
+	{
+		_video_size.width = node->number_child<int> ("VideoWidth");
+		_video_size.height = node->number_child<int> ("VideoHeight");
+		_video_frame_rate = node->optional_number_child<float> ("VideoFrameRate");
+		_sample_aspect_ratio = node->optional_number_child<float> ("SampleAspectRatio");
+		_video_length = node->number_child<VideoContent::Frame> ("VideoLength");
+		_first_video = node->optional_number_child<double> ("FirstVideo");
+		_probe_duration = node->optional_number_child<int64_t> ("ProbeDuration");
+
+		list<cxml::NodePtr> c = node->node_children ("SubtitleStream");
+		for (list<cxml::NodePtr>::const_iterator i = c.begin(); i != c.end(); ++i) {
+			_subtitle_streams.push_back (shared_ptr<FFmpegSubtitleStream> (new FFmpegSubtitleStream (*i)));
+		}
+
+		c = node->node_children ("AudioStream");
+		for (list<cxml::NodePtr>::const_iterator i = c.begin(); i != c.end(); ++i) {
+			_audio_streams.push_back (shared_ptr<FFmpegAudioStream> (new FFmpegAudioStream (*i, Film::current_state_version)));
+		}
+	}
+
+	/** @return Document suitable for ExaminationCache::set_examination
+	 *  holding the results of an FFmpegExaminer.
+	 */
+	static shared_ptr<xmlpp::Document> as_xml (shared_ptr<FFmpegExaminer> examiner)
+	{
+		shared_ptr<xmlpp::Document> doc (new xmlpp::Document);
+		xmlpp::Element* root = doc->create_root_node ("Examination");
+
+		root->add_child("VideoWidth")->add_child_text (raw_convert<string> (examiner->video_size().width));
+		root->add_child("VideoHeight")->add_child_text (raw_convert<string> (examiner->video_size().height));
+		if (examiner->video_frame_rate ()) {
+			root->add_child("VideoFrameRate")->add_child_text (raw_convert<string> (examiner->video_frame_rate().get ()));
+		}
+		if (examiner->sample_aspect_ratio ()) {
+			root->add_child("SampleAspectRatio")->add_child_text (raw_convert<string> (examiner->sample_aspect_ratio().get ()));
+		}
+		root->add_child("VideoLength")->add_child_text (raw_convert<string> (examiner->video_length ()));
+		if (examiner->first_video ()) {
+			root->add_child("FirstVideo")->add_child_text (raw_convert<string> (examiner->first_video().get ()));
+		}
+		root->add_child("ProbeDuration")->add_child_text (raw_convert<string> (examiner->probe_duration ()));
+
+		vector<shared_ptr<FFmpegSubtitleStream> > ss = examiner->subtitle_streams ();
+		for (vector<shared_ptr<FFmpegSubtitleStream> >::const_iterator i = ss.begin(); i != ss.end(); ++i) {
+			(*i)->as_xml (root->add_child ("SubtitleStream"));
+		}
+
+		vector<shared_ptr<FFmpegAudioStream> > as = examiner->audio_streams ();
+		for (vector<shared_ptr<FFmpegAudioStream> >::const_iterator i = as.begin(); i != as.end(); ++i) {
+			(*i)->as_xml (root->add_child ("AudioStream"));
+		}
+
+		return doc;
+	}
+
+	boost::optional<float> video_frame_rate () const {
+		return _video_frame_rate;
+	}
+
+	libdcp::Size video_size () const {
+		return _video_size;
+	}
+
+	VideoContent::Frame video_length () const {
+		return _video_length;
+	}
+
+	boost::optional<float> sample_aspect_ratio () const {
+		return _sample_aspect_ratio;
+	}
+
+	vector<shared_ptr<FFmpegSubtitleStream> > subtitle_streams () const {
+		return _subtitle_streams;
+	}
+
+	vector<shared_ptr<FFmpegAudioStream> > audio_streams () const {
+		return _audio_streams;
+	}
+
+	boost::optional<double> first_video () const {
+		return _first_video;
+	}
+
+	boost::optional<int64_t> probe_duration () const {
+		return _probe_duration;
+	}
+
+private:
+	libdcp::Size _video_size;
+	boost::optional<float> _video_frame_rate;
+	boost::optional<float> _sample_aspect_ratio;
+	VideoContent::Frame _video_length;
+	boost::optional<double> _first_video;
+	boost::optional<int64_t> _probe_duration;
+	vector<shared_ptr<FFmpegSubtitleStream> > _subtitle_streams;
+	vector<shared_ptr<FFmpegAudioStream> > _audio_streams;
+};
+
 void
 FFmpegContent::examine (shared_ptr<Job> job)
 {
-	job->set_progress_unknown ();
+	if (job) {
+		job->set_progress_unknown ();
+	}
 
 	Content::examine (job);
 
 	shared_ptr<const Film> film = _film.lock ();
 	DCPOMATIC_ASSERT (film);
 
-	shared_ptr<FFmpegExaminer> examiner (new FFmpegExaminer (shared_from_this (), job));
+	/* See if we have looked at these files before; if not, examine them
+	   and remember what we found.
+	*/
+	shared_ptr<VideoExaminer> video_examiner;
+	vector<shared_ptr<FFmpegSubtitleStream> > subtitle_streams;
+	vector<shared_ptr<FFmpegAudioStream> > audio_streams;
+	optional<double> first_video;
+	optional<int64_t> probe_duration;
+
+	shared_ptr<cxml::Document> cached = ExaminationCache::instance()->examination (paths ());
+	if (cached) {
+		shared_ptr<CachedFFmpegExamination> examination (new CachedFFmpegExamination (cached));
+		video_examiner = examination;
+		subtitle_streams = examination->subtitle_streams ();
+		audio_streams = examination->audio_streams ();
+		first_video = examination->first_video ();
+		probe_duration = examination->probe_duration ();
+		LOG_GENERAL ("Examination of %1 taken from cache", path_summary ());
+	} else {
+		shared_ptr<FFmpegExaminer> examiner (new FFmpegExaminer (shared_from_this (), job));
+		video_examiner = examiner;
+		subtitle_streams = examiner->subtitle_streams ();
+		audio_streams = examiner->audio_streams ();
+		first_video = examiner->first_video ();
+		probe_duration = examiner->probe_duration ();
+		ExaminationCache::instance()->set_examination (paths (), CachedFFmpegExamination::as_xml (examiner));
+	}
 
-	VideoContent::Frame video_length = 0;
-	video_length = examiner->video_length ();
+	VideoContent::Frame video_length = video_examiner->video_length ();
 	LOG_GENERAL ("Video length obtained from header as %1 frames", video_length);
 
 	{
@@ -181,17 +322,18 @@ FFmpegContent::examine (shared_ptr<Job> job)
 
 		_video_length = video_length;
 
-		_subtitle_streams = examiner->subtitle_streams ();
+		_subtitle_streams = subtitle_streams;
 		if (!_subtitle_streams.empty ()) {
 			_subtitle_stream = _subtitle_streams.front ();
 		}
 
-		_audio_streams = examiner->audio_streams ();
+		_audio_streams = audio_streams;
 
-		_first_video = examiner->first_video ();
+		_first_video = first_video;
+		_probe_duration = probe_duration;
 	}
 
-	take_from_video_examiner (examiner);
+	take_from_video_examiner (video_examiner);
 	set_default_audio_mapping ();
 
 	signal_changed (ContentProperty::LENGTH);
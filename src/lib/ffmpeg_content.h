@@ -171,6 +171,11 @@ public:
 		return _first_video;
 	}
 
+	boost::optional<int64_t> probe_duration () const {
+		boost::mutex::scoped_lock lm (_mutex);
+		return _probe_duration;
+	}
+
 private:
 	friend class ffmpeg_pts_offset_test;
 	friend class audio_sampling_rate_test;
@@ -179,6 +184,10 @@ private:
 	boost::shared_ptr<FFmpegSubtitleStream> _subtitle_stream;
 	std::vector<boost::shared_ptr<FFmpegAudioStream> > _audio_streams;
 	boost::optional<double> _first_video;
+	/** Duration in microseconds of the content that FFmpeg needs to look at to find
+	    all its stream information, if we know it.
+	*/
+	boost::optional<int64_t> _probe_duration;
 	/** Video filters that should be used when generating DCPs */
 	std::vector<Filter const *> _filters;
 };
@@ -41,6 +41,7 @@ extern "C" {
 #include "ffmpeg_decoder.h"
 #include "filter_graph.h"
 #include "audio_buffers.h"
+#include "audio_convert.h"
 #include "ffmpeg_content.h"
 #include "image_proxy.h"
 
@@ -81,6 +82,16 @@ FFmpegDecoder::FFmpegDecoder (shared_ptr<const Film> f, shared_ptr<const FFmpegC
 {
 	setup_subtitle ();
 
+	/* Make a table so that we can quickly find the audio stream (if any) for each packet */
+	_audio_streams_by_index.resize (_format_context->nb_streams);
+	BOOST_FOREACH (shared_ptr<FFmpegAudioStream> i, c->ffmpeg_audio_streams ()) {
+		for (uint32_t j = 0; j < _format_context->nb_streams; ++j) {
+			if (i->uses_index (_format_context, j)) {
+				_audio_streams_by_index[j] = i;
+			}
+		}
+	}
+
 	/* Audio and video frame PTS values may not start with 0.  We want
 	   to fiddle them so that:
 
@@ -203,130 +214,76 @@ FFmpegDecoder::pass ()
 	av_free_packet (&_packet);
 }
 
-/** @param data pointer to array of pointers to buffers.
+/** @param format Format of the samples in data.
+ *  @param data pointer to array of pointers to buffers.
  *  Only the first buffer will be used for non-planar data, otherwise there will be one per channel.
+ *  @return Deinterleaved audio; this may be the same AudioBuffers object as we returned last time,
+ *  re-used if nobody else kept hold of it.
  */
 shared_ptr<AudioBuffers>
-FFmpegDecoder::deinterleave_audio (shared_ptr<const FFmpegAudioStream> stream, uint8_t** data, int size)
+FFmpegDecoder::deinterleave_audio (shared_ptr<const FFmpegAudioStream> stream, AVSampleFormat format, uint8_t** data, int size)
 {
-	DCPOMATIC_ASSERT (stream->channels());
-	DCPOMATIC_ASSERT (bytes_per_audio_sample (stream));
+	int const channels = stream->channels ();
+	int const bytes_per_sample = av_get_bytes_per_sample (format);
+
+	DCPOMATIC_ASSERT (channels);
+	DCPOMATIC_ASSERT (bytes_per_sample);
 
 	/* Deinterleave and convert to float */
 
 	/* total_samples and frames will be rounded down here, so if there are stray samples at the end
 	   of the block that do not form a complete sample or frame they will be dropped.
 	*/
-	int const total_samples = size / bytes_per_audio_sample (stream);
-	int const frames = total_samples / stream->channels();
-	shared_ptr<AudioBuffers> audio (new AudioBuffers (stream->channels(), frames));
+	int const total_samples = size / bytes_per_sample;
+	int const frames = total_samples / channels;
 
-	switch (audio_sample_format (stream)) {
-	case AV_SAMPLE_FMT_U8:
-	{
-		uint8_t* p = reinterpret_cast<uint8_t *> (data[0]);
-		int sample = 0;
-		int channel = 0;
-		for (int i = 0; i < total_samples; ++i) {
-			audio->data(channel)[sample] = float(*p++) / (1 << 23);
-
-			++channel;
-			if (channel == stream->channels()) {
-				channel = 0;
-				++sample;
-			}
-		}
+	if (!_deinterleaved || !_deinterleaved.unique () || _deinterleaved->channels() != channels) {
+		_deinterleaved.reset (new AudioBuffers (channels, frames));
+	} else {
+		_deinterleaved->ensure_size (frames);
+		_deinterleaved->set_frames (frames);
 	}
-	break;
 
-	case AV_SAMPLE_FMT_S16:
-	{
-		int16_t* p = reinterpret_cast<int16_t *> (data[0]);
-		int sample = 0;
-		int channel = 0;
-		for (int i = 0; i < total_samples; ++i) {
-			audio->data(channel)[sample] = float(*p++) / (1 << 15);
-
-			++channel;
-			if (channel == stream->channels()) {
-				channel = 0;
-				++sample;
-			}
-		}
-	}
-	break;
+	float** out = _deinterleaved->data ();
 
+	switch (format) {
+	case AV_SAMPLE_FMT_U8:
+		deinterleave_samples (reinterpret_cast<uint8_t const *> (data[0]), channels, frames, out);
+		break;
+	case AV_SAMPLE_FMT_U8P:
+		for (int i = 0; i < channels; ++i) {
+			convert_samples (reinterpret_cast<uint8_t const *> (data[i]), frames, out[i]);
+		}
+		break;
+	case AV_SAMPLE_FMT_S16:
+		deinterleave_samples (reinterpret_cast<int16_t const *> (data[0]), channels, frames, out);
+		break;
 	case AV_SAMPLE_FMT_S16P:
-	{
-		int16_t** p = reinterpret_cast<int16_t **> (data);
-		for (int i = 0; i < stream->channels(); ++i) {
-			for (int j = 0; j < frames; ++j) {
-				audio->data(i)[j] = static_cast<float>(p[i][j]) / (1 << 15);
-			}
+		for (int i = 0; i < channels; ++i) {
+			convert_samples (reinterpret_cast<int16_t const *> (data[i]), frames, out[i]);
 		}
-	}
-	break;
-
+		break;
 	case AV_SAMPLE_FMT_S32:
-	{
-		int32_t* p = reinterpret_cast<int32_t *> (data[0]);
-		int sample = 0;
-		int channel = 0;
-		for (int i = 0; i < total_samples; ++i) {
-			audio->data(channel)[sample] = static_cast<float>(*p++) / (1 << 31);
-
-			++channel;
-			if (channel == stream->channels()) {
-				channel = 0;
-				++sample;
-			}
+		deinterleave_samples (reinterpret_cast<int32_t const *> (data[0]), channels, frames, out);
+		break;
+	case AV_SAMPLE_FMT_S32P:
+		for (int i = 0; i < channels; ++i) {
+			convert_samples (reinterpret_cast<int32_t const *> (data[i]), frames, out[i]);
 		}
-	}
-	break;
-
+		break;
 	case AV_SAMPLE_FMT_FLT:
-	{
-		float* p = reinterpret_cast<float*> (data[0]);
-		int sample = 0;
-		int channel = 0;
-		for (int i = 0; i < total_samples; ++i) {
-			audio->data(channel)[sample] = *p++;
-
-			++channel;
-			if (channel == stream->channels()) {
-				channel = 0;
-				++sample;
-			}
-		}
-	}
-	break;
-
+		deinterleave_samples (reinterpret_cast<float const *> (data[0]), channels, frames, out);
+		break;
 	case AV_SAMPLE_FMT_FLTP:
-	{
-		float** p = reinterpret_cast<float**> (data);
-		for (int i = 0; i < stream->channels(); ++i) {
-			memcpy (audio->data(i), p[i], frames * sizeof(float));
+		for (int i = 0; i < channels; ++i) {
+			convert_samples (reinterpret_cast<float const *> (data[i]), frames, out[i]);
 		}
-	}
-	break;
-
+		break;
 	default:
-		throw DecodeError (String::compose (_("Unrecognised audio sample format (%1)"), static_cast<int> (audio_sample_format (stream))));
+		throw DecodeError (String::compose (_("Unrecognised audio sample format (%1)"), static_cast<int> (format)));
 	}
 
-	return audio;
-}
-
-AVSampleFormat
-FFmpegDecoder::audio_sample_format (shared_ptr<const FFmpegAudioStream> stream) const
-{
-	return stream->stream (_format_context)->codec->sample_fmt;
-}
-
-int
-FFmpegDecoder::bytes_per_audio_sample (shared_ptr<const FFmpegAudioStream> stream) const
-{
-	return av_get_bytes_per_sample (audio_sample_format (stream));
+	return _deinterleaved;
 }
 
 void
@@ -449,25 +406,25 @@ FFmpegDecoder::decode_audio_packet ()
 
 	AVPacket copy_packet = _packet;
 
-	/* XXX: inefficient */
-	vector<shared_ptr<FFmpegAudioStream> > streams = ffmpeg_content()->ffmpeg_audio_streams ();
-	vector<shared_ptr<FFmpegAudioStream> >::const_iterator stream = streams.begin ();
-	while (stream != streams.end () && !(*stream)->uses_index (_format_context, copy_packet.stream_index)) {
-		++stream;
+	if (copy_packet.stream_index < 0 || copy_packet.stream_index >= int (_audio_streams_by_index.size ())) {
+		return;
 	}
 
-	if (stream == streams.end ()) {
+	shared_ptr<FFmpegAudioStream> stream = _audio_streams_by_index[copy_packet.stream_index];
+	if (!stream) {
 		/* The packet's stream may not be an audio one; just ignore it in this method if so */
 		return;
 	}
 
+	AVCodecContext* codec = _format_context->streams[copy_packet.stream_index]->codec;
+
 	/* This is just for LOG_WARNING */
 	shared_ptr<const Film> film = _film.lock ();
 
 	while (copy_packet.size > 0) {
 
 		int frame_finished;
-		int decode_result = avcodec_decode_audio4 ((*stream)->stream (_format_context)->codec, _frame, &frame_finished, &copy_packet);
+		int decode_result = avcodec_decode_audio4 (codec, _frame, &frame_finished, &copy_packet);
 		if (decode_result < 0) {
 			/* avcodec_decode_audio4 can sometimes return an error even though it has decoded
 			   some valid data; for example dca_subframe_footer can return AVERROR_INVALIDDATA
@@ -489,7 +446,7 @@ FFmpegDecoder::decode_audio_packet ()
 
 		if (frame_finished) {
 
-			if (_audio_position[*stream] == 0) {
+			if (_audio_position[stream] == 0) {
 				/* Where we are in the source, in seconds */
 				double const pts = av_q2d (_format_context->streams[copy_packet.stream_index]->time_base)
 					* av_frame_get_best_effort_timestamp(_frame) + _pts_offset;
@@ -498,26 +455,26 @@ FFmpegDecoder::decode_audio_packet ()
 
 				if (pts > 0) {
 					/* Emit some silence */
-					int64_t frames = pts * (*stream)->frame_rate ();
+					int64_t frames = pts * stream->frame_rate ();
 					while (frames > 0) {
-						int64_t const this_time = min (frames, (int64_t) (*stream)->frame_rate() / 2);
+						int64_t const this_time = min (frames, (int64_t) stream->frame_rate() / 2);
 
 						shared_ptr<AudioBuffers> silence (
-							new AudioBuffers ((*stream)->channels(), this_time)
+							new AudioBuffers (stream->channels(), this_time)
 							);
 
 						silence->make_silent ();
-						audio (silence, *stream, _audio_position[*stream]);
+						audio (silence, stream, _audio_position[stream]);
 						frames -= this_time;
 					}
 				}
 			}
 
 			int const data_size = av_samples_get_buffer_size (
-				0, (*stream)->stream(_format_context)->codec->channels, _frame->nb_samples, audio_sample_format (*stream), 1
+				0, codec->channels, _frame->nb_samples, codec->sample_fmt, 1
 				);
 
-			audio (deinterleave_audio (*stream, _frame->data, data_size), *stream, _audio_position[*stream]);
+			audio (deinterleave_audio (stream, codec->sample_fmt, _frame->data, data_size), stream, _audio_position[stream]);
 		}
 
 		copy_packet.data += decode_result;
@@ -64,15 +64,12 @@ private:
 
 	void setup_subtitle ();
 
-	AVSampleFormat audio_sample_format (boost::shared_ptr<const FFmpegAudioStream> stream) const;
-	int bytes_per_audio_sample (boost::shared_ptr<const FFmpegAudioStream> stream) const;
-
 	bool decode_video_packet ();
 	void decode_audio_packet ();
 	void decode_subtitle_packet ();
 
 	void maybe_add_subtitle ();
-	boost::shared_ptr<AudioBuffers> deinterleave_audio (boost::shared_ptr<const FFmpegAudioStream> stream, uint8_t** data, int size);
+	boost::shared_ptr<AudioBuffers> deinterleave_audio (boost::shared_ptr<const FFmpegAudioStream> stream, AVSampleFormat format, uint8_t** data, int size);
 
 	AVCodecContext* _subtitle_codec_context; ///< may be 0 if there is no subtitle
 	AVCodec* _subtitle_codec;		 ///< may be 0 if there is no subtitle
@@ -83,6 +80,13 @@ private:
 	bool _decode_video;
 	bool _decode_audio;
 
+	/** our audio streams, indexed by the index of the corresponding stream in _format_context;
+	    entries for streams which are not audio are 0.
+	*/
+	std::vector<boost::shared_ptr<FFmpegAudioStream> > _audio_streams_by_index;
+	/** buffers that deinterleave_audio last returned */
+	boost::shared_ptr<AudioBuffers> _deinterleaved;
+
 	/** Offset to add to FFmpeg frame timestamps to get our position (in seconds) */
 	double _pts_offset;
 	bool _just_sought;
@@ -18,6 +18,7 @@
 */
 
 #include <cstdio>
+#include <algorithm>
 #include <sndfile.h>
 #include "file_group.h"
 #include "exceptions.h"
@@ -25,19 +26,28 @@
 
 using std::vector;
 using std::cout;
+using std::upper_bound;
+
+/** Number of bytes that we ask to be read before we get to them */
+static int64_t const read_ahead_size = 32 * 1024 * 1024;
 
 FileGroup::FileGroup ()
 	: _current_path (0)
 	, _current_file (0)
+	, _read_ahead (false)
+	, _prefetched_next (false)
 {
-
+	setup_offsets ();
 }
 
 FileGroup::FileGroup (boost::filesystem::path p)
 	: _current_path (0)
 	, _current_file (0)
+	, _read_ahead (false)
+	, _prefetched_next (false)
 {
 	_paths.push_back (p);
+	setup_offsets ();
 	seek (0, SEEK_SET);
 }
 
@@ -45,8 +55,11 @@ FileGroup::FileGroup (vector<boost::filesystem::path> const & p)
 	: _paths (p)
 	, _current_path (0)
 	, _current_file (0)
+	, _read_ahead (false)
+	, _prefetched_next (false)
 {
-	ensure_open_path (0);
+	setup_offsets ();
+	ensure_open_path (0, 0);
 	seek (0, SEEK_SET);
 }
 
@@ -61,13 +74,50 @@ void
 FileGroup::set_paths (vector<boost::filesystem::path> const & p)
 {
 	_paths = p;
-	ensure_open_path (0);
+	setup_offsets ();
+	ensure_open_path (0, 0);
 	seek (0, SEEK_SET);
 }
 
-/** Ensure that the given path index in the content is the _current_file */
+/** @param r true to ask the operating system to read our files ahead of us,
+ *  carrying on from the end of one file to the start of the next.
+ */
+void
+FileGroup::set_read_ahead (bool r)
+{
+	_read_ahead = r;
+	if (_read_ahead && _current_file) {
+#ifdef DCPOMATIC_WINDOWS
+		int64_t const position = _ftelli64 (_current_file);
+#else
+		int64_t const position = ftell (_current_file);
+#endif
+		read_ahead (_current_file, position, read_ahead_size);
+	}
+}
+
+/** Find the sizes of our files, once, so that we need not look at the filesystem
+ *  again when seeking.
+ */
+void
+FileGroup::setup_offsets ()
+{
+	_offsets.clear ();
+	int64_t offset = 0;
+	for (vector<boost::filesystem::path>::const_iterator i = _paths.begin(); i != _paths.end(); ++i) {
+		_offsets.push_back (offset);
+		offset += boost::filesystem::file_size (*i);
+	}
+	_offsets.push_back (offset);
+}
+
+/** Ensure that the given path index in the content is the _current_file.
+ *  @param p Path index.
+ *  @param offset Offset within the path that we are about to read from, used
+ *  to decide what to read ahead if the path has to be opened.
+ */
 void
-FileGroup::ensure_open_path (size_t p) const
+FileGroup::ensure_open_path (size_t p, int64_t offset) const
 {
 	if (_current_file && _current_path == p) {
 		/* Already open */
@@ -83,6 +133,22 @@ FileGroup::ensure_open_path (size_t p) const
 	if (_current_file == 0) {
 		throw OpenFileError (_paths[_current_path]);
 	}
+
+	_prefetched_next = false;
+	if (_read_ahead) {
+		read_ahead (_current_file, offset, read_ahead_size);
+	}
+}
+
+/** Ask for the start of one of our paths to be read ahead of us */
+void
+FileGroup::prefetch (size_t p) const
+{
+	FILE* f = fopen_boost (_paths[p], "rb");
+	if (f) {
+		read_ahead (f, 0, read_ahead_size);
+		fclose (f);
+	}
 }
 
 int64_t
@@ -97,9 +163,7 @@ FileGroup::seek (int64_t pos, int whence) const
 		full_pos = pos;
 		break;
 	case SEEK_CUR:
-		for (size_t i = 0; i < _current_path; ++i) {
-			full_pos += boost::filesystem::file_size (_paths[i]);
-		}
+		full_pos = _offsets[_current_path];
 #ifdef DCPOMATIC_WINDOWS
 		full_pos += _ftelli64 (_current_file);
 #else
@@ -112,24 +176,15 @@ FileGroup::seek (int64_t pos, int whence) const
 		break;
 	}
 
-	/* Seek to full_pos */
-	size_t i = 0;
-	int64_t sub_pos = full_pos;
-	while (i < _paths.size ()) {
-		boost::uintmax_t len = boost::filesystem::file_size (_paths[i]);
-		if (sub_pos < int64_t (len)) {
-			break;
-		}
-		sub_pos -= len;
-		++i;
-	}
-
-	if (i == _paths.size ()) {
+	if (full_pos < 0 || full_pos >= length ()) {
 		return -1;
 	}
 
-	ensure_open_path (i);
-	dcpomatic_fseek (_current_file, sub_pos, SEEK_SET);
+	/* Seek to full_pos; the path that we want is the last one which starts at or before it */
+	size_t const i = upper_bound (_offsets.begin(), _offsets.end(), full_pos) - _offsets.begin() - 1;
+
+	ensure_open_path (i, full_pos - _offsets[i]);
+	dcpomatic_fseek (_current_file, full_pos - _offsets[i], SEEK_SET);
 	return full_pos;
 }
 
@@ -154,7 +209,21 @@ FileGroup::read (uint8_t* buffer, int amount) const
 		if ((_current_path + 1) >= _paths.size()) {
 			break;
 		}
-		ensure_open_path (_current_path + 1);
+		ensure_open_path (_current_path + 1, 0);
+	}
+
+	if (_read_ahead && !_prefetched_next && (_current_path + 1) < _paths.size()) {
+		/* Start reading the next file if we are nearly at the end of this one */
+#ifdef DCPOMATIC_WINDOWS
+		int64_t const position = _ftelli64 (_current_file);
+#else
+		int64_t const position = ftell (_current_file);
+#endif
+		int64_t const remaining = _offsets[_current_path + 1] - _offsets[_current_path] - position;
+		if (remaining < read_ahead_size) {
+			prefetch (_current_path + 1);
+			_prefetched_next = true;
+		}
 	}
 
 	return read;
@@ -163,10 +232,5 @@ FileGroup::read (uint8_t* buffer, int amount) const
 int64_t
 FileGroup::length () const
 {
-	int64_t len = 0;
-	for (size_t i = 0; i < _paths.size(); ++i) {
-		len += boost::filesystem::file_size (_paths[i]);
-	}
-
-	return len;
+	return _offsets.back ();
 }
@@ -32,18 +32,29 @@ public:
 	~FileGroup ();
 
 	void set_paths (std::vector<boost::filesystem::path> const &);
+	void set_read_ahead (bool);
 
 	int64_t seek (int64_t, int) const;
 	int read (uint8_t*, int) const;
 	int64_t length () const;
 
 private:
-	void ensure_open_path (size_t) const;
+	void setup_offsets ();
+	void ensure_open_path (size_t, int64_t) const;
+	void prefetch (size_t) const;
 
 	std::vector<boost::filesystem::path> _paths;
+	/** Offset of the start of each of _paths from the start of the first,
+	    with the total length of all the files on the end.
+	*/
+	std::vector<int64_t> _offsets;
 	/** Index of path that we are currently reading from */
 	mutable size_t _current_path;
 	mutable FILE* _current_file;
+	/** true to ask the operating system to read ahead of us */
+	bool _read_ahead;
+	/** true if we have asked for the start of the path after _current_path to be read ahead */
+	mutable bool _prefetched_next;
 };
 
 #endif
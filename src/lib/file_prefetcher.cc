@@ -0,0 +1,196 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "file_prefetcher.h"
+#include "exceptions.h"
+#include "cross.h"
+#include "util.h"
+
+using std::vector;
+using std::map;
+using std::set;
+using std::min;
+
+/** @param paths Files to read.
+ *  @param depth Number of files after the one most recently asked for to read ahead.
+ *  @param threads Number of files to read at the same time.
+ */
+FilePrefetcher::FilePrefetcher (vector<boost::filesystem::path> paths, int depth, int threads)
+	: _paths (paths)
+	, _depth (depth)
+	, _position (0)
+	, _stop (false)
+{
+	for (int i = 0; i < threads; ++i) {
+		_threads.create_thread (boost::bind (&FilePrefetcher::thread, this));
+	}
+}
+
+FilePrefetcher::~FilePrefetcher ()
+{
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		_stop = true;
+		_condition.notify_all ();
+	}
+
+	_threads.join_all ();
+}
+
+/** Say that we are interested in files from index onwards, and forget about any earlier
+ *  ones or any which are now too far ahead.  Must be called with _mutex held.
+ */
+void
+FilePrefetcher::set_window (size_t index)
+{
+	_position = index;
+
+	map<size_t, Magick::Blob>::iterator i = _done.begin ();
+	while (i != _done.end ()) {
+		if (i->first < _position || i->first > (_position + _depth)) {
+			_done.erase (i++);
+		} else {
+			++i;
+		}
+	}
+
+	set<size_t>::iterator j = _failed.begin ();
+	while (j != _failed.end ()) {
+		if (*j < _position || *j > (_position + _depth)) {
+			_failed.erase (j++);
+		} else {
+			++j;
+		}
+	}
+
+	_condition.notify_all ();
+}
+
+/** @param index Index of a file within our paths.
+ *  @return Contents of the file, read in the background if possible.  Reading
+ *  this file also tells us that the following files will be wanted soon, and
+ *  that earlier ones (unless asked for again) will not.
+ */
+Magick::Blob
+FilePrefetcher::get (size_t index)
+{
+	DCPOMATIC_ASSERT (index < _paths.size ());
+
+	boost::mutex::scoped_lock lm (_mutex);
+
+	set_window (index);
+
+	while (true) {
+		map<size_t, Magick::Blob>::iterator i = _done.find (index);
+		if (i != _done.end ()) {
+			Magick::Blob b = i->second;
+			_done.erase (i);
+			/* Move the window on so that another file can be read ahead */
+			set_window (index + 1);
+			return b;
+		}
+
+		if (_failed.find (index) != _failed.end () || _threads.size() == 0) {
+			/* Read it here so that any error is thrown from here */
+			lm.unlock ();
+			Magick::Blob b = read (_paths[index]);
+			lm.lock ();
+			set_window (index + 1);
+			return b;
+		}
+
+		_condition.wait (lm);
+	}
+}
+
+void
+FilePrefetcher::thread ()
+{
+	boost::mutex::scoped_lock lm (_mutex);
+
+	while (true) {
+		if (_stop) {
+			return;
+		}
+
+		/* Find the earliest file in our window which is not done or being done */
+		size_t const end = min (_paths.size(), _position + _depth + 1);
+		size_t index = _position;
+		while (
+			index < end &&
+			(_done.find (index) != _done.end() || _reading.find (index) != _reading.end() || _failed.find (index) != _failed.end())
+			) {
+			++index;
+		}
+
+		if (index == end) {
+			_condition.wait (lm);
+			continue;
+		}
+
+		_reading.insert (index);
+		lm.unlock ();
+
+		Magick::Blob b;
+		bool ok = true;
+		try {
+			b = read (_paths[index]);
+		} catch (...) {
+			ok = false;
+		}
+
+		lm.lock ();
+		_reading.erase (index);
+
+		if (index >= _position && index <= (_position + _depth)) {
+			if (ok) {
+				_done[index] = b;
+			} else {
+				_failed.insert (index);
+			}
+		}
+
+		_condition.notify_all ();
+	}
+}
+
+/** @return Contents of a file */
+Magick::Blob
+FilePrefetcher::read (boost::filesystem::path path)
+{
+	boost::uintmax_t const size = boost::filesystem::file_size (path);
+	FILE* f = fopen_boost (path, "rb");
+	if (!f) {
+		throw OpenFileError (path);
+	}
+
+	uint8_t* data = new uint8_t[size];
+	if (fread (data, 1, size, f) != size) {
+		fclose (f);
+		delete[] data;
+		throw ReadFileError (path);
+	}
+
+	fclose (f);
+
+	Magick::Blob blob;
+	blob.update (data, size);
+	delete[] data;
+	return blob;
+}
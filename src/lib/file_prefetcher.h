@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef DCPOMATIC_FILE_PREFETCHER_H
+#define DCPOMATIC_FILE_PREFETCHER_H
+
+/** @file  src/lib/file_prefetcher.h
+ *  @brief FilePrefetcher class.
+ */
+
+#include <vector>
+#include <map>
+#include <set>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/noncopyable.hpp>
+#include <Magick++.h>
+
+/** @class FilePrefetcher
+ *  @brief Reads files from a list in the background, a few ahead of where they are wanted.
+ *
+ *  This is for image sequences, where each frame is a file: rather than reading each
+ *  file only when it is needed, a few threads read the next few files while earlier
+ *  ones are being used.  On network storage, where the time taken to read a file is
+ *  mostly waiting, this means that several reads can be waiting at the same time.
+ */
+class FilePrefetcher : public boost::noncopyable
+{
+public:
+	FilePrefetcher (std::vector<boost::filesystem::path> paths, int depth, int threads);
+	~FilePrefetcher ();
+
+	Magick::Blob get (size_t index);
+
+	static Magick::Blob read (boost::filesystem::path);
+
+private:
+	void thread ();
+	void set_window (size_t index);
+
+	std::vector<boost::filesystem::path> _paths;
+	/** number of files after the one most recently asked for that we should read ahead */
+	int _depth;
+
+	boost::thread_group _threads;
+
+	/** mutex for everything below */
+	boost::mutex _mutex;
+	/** condition to wake our threads when there is something for them to read,
+	    and to wake get() when something has been read.
+	*/
+	boost::condition _condition;
+	/** index of the first file that we are interested in */
+	size_t _position;
+	/** files that we have read */
+	std::map<size_t, Magick::Blob> _done;
+	/** files that could not be read */
+	std::set<size_t> _failed;
+	/** files that one of our threads is reading */
+	std::set<size_t> _reading;
+	bool _stop;
+};
+
+#endif
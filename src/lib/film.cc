@@ -23,6 +23,7 @@
 #include <fstream>
 #include <cstdlib>
 #include <iomanip>
+#include <set>
 #include <unistd.h>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
@@ -56,6 +57,7 @@
 #include "cross.h"
 #include "cinema.h"
 #include "safe_stringstream.h"
+#include "video_content.h"
 
 #include "i18n.h"
 
@@ -71,6 +73,7 @@ using std::make_pair;
 using std::endl;
 using std::cout;
 using std::list;
+using std::set;
 using boost::shared_ptr;
 using boost::weak_ptr;
 using boost::dynamic_pointer_cast;
@@ -122,6 +125,8 @@ Film::Film (boost::filesystem::path dir, bool log)
 	, _three_d (false)
 	, _sequence_video (true)
 	, _interop (false)
+	, _reel_type (REELTYPE_SINGLE)
+	, _reel_length (2000000000)
 	, _state_version (current_state_version)
 	, _dirty (false)
 {
@@ -219,10 +224,18 @@ Film::internal_video_mxf_dir () const
 	return dir ("video");
 }
 
+/** @param reel Period of the reel, as returned by reels().
+ *  A single-reel film keeps the name used before films could be split into reels,
+ *  so that encodes started before then can still be resumed.
+ */
 boost::filesystem::path
-Film::internal_video_mxf_filename () const
+Film::internal_video_mxf_filename (pair<int, int> reel) const
 {
-	return video_identifier() + ".mxf";
+	if (reels().size() == 1) {
+		return video_identifier() + ".mxf";
+	}
+
+	return String::compose ("%1_%2_%3.mxf", video_identifier(), reel.first, reel.second);
 }
 
 string
@@ -360,6 +373,8 @@ Film::metadata () const
 	root->add_child("ThreeD")->add_child_text (_three_d ? "1" : "0");
 	root->add_child("SequenceVideo")->add_child_text (_sequence_video ? "1" : "0");
 	root->add_child("Interop")->add_child_text (_interop ? "1" : "0");
+	root->add_child("ReelType")->add_child_text (raw_convert<string> (_reel_type));
+	root->add_child("ReelLength")->add_child_text (raw_convert<string> (_reel_length));
 	root->add_child("Signed")->add_child_text (_signed ? "1" : "0");
 	root->add_child("Encrypted")->add_child_text (_encrypted ? "1" : "0");
 	root->add_child("Key")->add_child_text (_key.hex ());
@@ -440,6 +455,8 @@ Film::read_metadata ()
 	_sequence_video = f.bool_child ("SequenceVideo");
 	_three_d = f.bool_child ("ThreeD");
 	_interop = f.bool_child ("Interop");
+	_reel_type = static_cast<ReelType> (f.optional_number_child<int> ("ReelType").get_value_or (REELTYPE_SINGLE));
+	_reel_length = f.optional_number_child<int64_t> ("ReelLength").get_value_or (2000000000);
 	_key = libdcp::Key (f.string_child ("Key"));
 
 	list<string> notes;
@@ -838,31 +855,14 @@ Film::set_isdcf_date_today ()
 	_isdcf_date = boost::gregorian::day_clock::local_day ();
 }
 
+/** @return Directory for the Writer to spill JPEG2000 data into */
 boost::filesystem::path
-Film::j2c_path (int f, Eyes e, bool t) const
+Film::j2c_dir () const
 {
 	boost::filesystem::path p;
 	p /= "j2c";
 	p /= video_identifier ();
-
-	SafeStringStream s;
-	s.width (8);
-	s << setfill('0') << f;
-
-	if (e == EYES_LEFT) {
-		s << ".L";
-	} else if (e == EYES_RIGHT) {
-		s << ".R";
-	}
-
-	s << ".j2c";
-
-	if (t) {
-		s << ".tmp";
-	}
-
-	p /= s.str();
-	return file (p);
+	return dir (p);
 }
 
 /** Find all the DCPs in our directory that can be libdcp::DCP::read() and return details of their CPLs */
@@ -937,29 +937,49 @@ Film::content () const
 void
 Film::examine_and_add_content (shared_ptr<Content> c)
 {
-	if (dynamic_pointer_cast<FFmpegContent> (c)) {
-		run_ffprobe (c->path(0), file ("ffprobe.log"), _log);
+	examine_and_add_content (ContentList (1, c));
+}
+
+/** Examine some content (in parallel, if there is more than one piece) and then
+ *  add whatever was examined successfully to the playlist in the order given.
+ */
+void
+Film::examine_and_add_content (ContentList c)
+{
+	if (c.empty ()) {
+		return;
+	}
+
+	/* Each run of ffprobe overwrites the log, so there's only any point in doing the last one */
+	for (ContentList::reverse_iterator i = c.rbegin(); i != c.rend(); ++i) {
+		if (dynamic_pointer_cast<FFmpegContent> (*i)) {
+			run_ffprobe ((*i)->path(0), file ("ffprobe.log"), _log);
+			break;
+		}
 	}
 
-	shared_ptr<Job> j (new ExamineContentJob (shared_from_this(), c));
+	shared_ptr<ExamineContentJob> j (new ExamineContentJob (shared_from_this(), c));
 
 	_job_connections.push_back (
-		j->Finished.connect (bind (&Film::maybe_add_content, this, boost::weak_ptr<Job> (j), boost::weak_ptr<Content> (c)))
+		j->Finished.connect (bind (&Film::maybe_add_content, this, boost::weak_ptr<ExamineContentJob> (j)))
 		);
 
 	JobManager::instance()->add (j);
 }
 
 void
-Film::maybe_add_content (weak_ptr<Job> j, weak_ptr<Content> c)
+Film::maybe_add_content (weak_ptr<ExamineContentJob> j)
 {
-	shared_ptr<Job> job = j.lock ();
-	if (!job || !job->finished_ok ()) {
+	shared_ptr<ExamineContentJob> job = j.lock ();
+	if (!job || job->finished_cancelled ()) {
 		return;
 	}
 
-	shared_ptr<Content> content = c.lock ();
-	if (content) {
+	/* If some of the content could not be examined the job will have finished
+	   in error, but we still add the content that was OK.
+	*/
+	ContentList content = job->examined ();
+	if (!content.empty ()) {
 		add_content (content);
 	}
 }
@@ -975,6 +995,21 @@ Film::add_content (shared_ptr<Content> c)
 	_playlist->add (c);
 }
 
+/** Add some pieces of content; any video content is added after the existing content, in the order given */
+void
+Film::add_content (ContentList c)
+{
+	Time end = _playlist->video_end ();
+	for (ContentList::iterator i = c.begin(); i != c.end(); ++i) {
+		if (dynamic_pointer_cast<VideoContent> (*i)) {
+			(*i)->set_position (end);
+			end = (*i)->end ();
+		}
+	}
+
+	_playlist->add (c);
+}
+
 void
 Film::remove_content (shared_ptr<Content> c)
 {
@@ -1073,6 +1108,74 @@ Film::audio_frame_rate () const
 	return 48000;
 }
 
+void
+Film::set_reel_type (ReelType t)
+{
+	_reel_type = t;
+	signal_changed (REEL_TYPE);
+}
+
+void
+Film::set_reel_length (int64_t r)
+{
+	_reel_length = r;
+	signal_changed (REEL_LENGTH);
+}
+
+/** @return The reels that our DCP should be split into, as periods of
+ *  [first video frame, last video frame + 1).  There is always at least one,
+ *  and only a film shorter than a second will have one shorter than a second.
+ */
+list<pair<int, int> >
+Film::reels () const
+{
+	int const length = time_to_video_frames (this->length ());
+
+	/* Frames at which new reels start, other than 0 */
+	set<int> splits;
+
+	switch (_reel_type) {
+	case REELTYPE_SINGLE:
+		break;
+	case REELTYPE_BY_VIDEO_CONTENT:
+	{
+		ContentList cl = content ();
+		for (ContentList::const_iterator i = cl.begin(); i != cl.end(); ++i) {
+			if (dynamic_pointer_cast<VideoContent> (*i)) {
+				splits.insert (time_to_video_frames ((*i)->position ()));
+			}
+		}
+		break;
+	}
+	case REELTYPE_BY_LENGTH:
+	{
+		/* Number of frames that will take up about _reel_length bytes */
+		int const frames = max (int64_t (1), _reel_length * 8 * video_frame_rate() / j2k_bandwidth());
+		for (int i = frames; i < length; i += frames) {
+			splits.insert (i);
+		}
+		break;
+	}
+	}
+
+	/* Don't make any reel shorter than a second; a split which would do that is dropped,
+	   so that the short piece becomes part of the reel next to it.
+	*/
+	int const minimum = video_frame_rate ();
+
+	list<pair<int, int> > reels;
+	int from = 0;
+	for (set<int>::const_iterator i = splits.begin(); i != splits.end(); ++i) {
+		if (*i - from >= minimum && length - *i >= minimum) {
+			reels.push_back (make_pair (from, *i));
+			from = *i;
+		}
+	}
+	reels.push_back (make_pair (from, max (from, length)));
+
+	return reels;
+}
+
 void
 Film::set_sequence_video (bool s)
 {
@@ -46,6 +46,7 @@ class Playlist;
 class AudioContent;
 class Scaler;
 class Screen;
+class ExamineContentJob;
 class isdcf_name_test;
 
 /** @class Film
@@ -62,9 +63,9 @@ public:
 	~Film ();
 
 	boost::filesystem::path info_file () const;
-	boost::filesystem::path j2c_path (int, Eyes, bool) const;
+	boost::filesystem::path j2c_dir () const;
 	boost::filesystem::path internal_video_mxf_dir () const;
-	boost::filesystem::path internal_video_mxf_filename () const;
+	boost::filesystem::path internal_video_mxf_filename (std::pair<int, int> reel) const;
 	boost::filesystem::path audio_analysis_dir () const;
 
 	void send_dcp_to_tms ();
@@ -164,6 +165,8 @@ public:
 		THREE_D,
 		SEQUENCE_VIDEO,
 		INTEROP,
+		REEL_TYPE,
+		REEL_LENGTH,
 	};
 
 
@@ -243,6 +246,16 @@ public:
 		return _interop;
 	}
 
+	ReelType reel_type () const {
+		return _reel_type;
+	}
+
+	int64_t reel_length () const {
+		return _reel_length;
+	}
+
+	std::list<std::pair<int, int> > reels () const;
+
 
 	/* SET */
 
@@ -250,7 +263,9 @@ public:
 	void set_name (std::string);
 	void set_use_isdcf_name (bool);
 	void examine_and_add_content (boost::shared_ptr<Content>);
+	void examine_and_add_content (ContentList);
 	void add_content (boost::shared_ptr<Content>);
+	void add_content (ContentList);
 	void remove_content (boost::shared_ptr<Content>);
 	void move_content_earlier (boost::shared_ptr<Content>);
 	void move_content_later (boost::shared_ptr<Content>);
@@ -270,6 +285,8 @@ public:
 	void set_isdcf_date_today ();
 	void set_sequence_video (bool);
 	void set_interop (bool);
+	void set_reel_type (ReelType);
+	void set_reel_length (int64_t);
 
 	/** Emitted when some property has of the Film has changed */
 	mutable boost::signals2::signal<void (Property)> Changed;
@@ -289,7 +306,7 @@ private:
 	void playlist_changed ();
 	void playlist_content_changed (boost::weak_ptr<Content>, int);
 	std::string filename_safe_name () const;
-	void maybe_add_content (boost::weak_ptr<Job>, boost::weak_ptr<Content>);
+	void maybe_add_content (boost::weak_ptr<ExamineContentJob>);
 
 	/** Log to write to */
 	boost::shared_ptr<Log> _log;
@@ -332,6 +349,9 @@ private:
 	bool _three_d;
 	bool _sequence_video;
 	bool _interop;
+	ReelType _reel_type;
+	/** Desired reel length in bytes, if _reel_type is REELTYPE_BY_LENGTH */
+	int64_t _reel_length;
 	libdcp::Key _key;
 
 	int _state_version;
@@ -0,0 +1,254 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <cerrno>
+#include <cstring>
+#ifdef DCPOMATIC_POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include "frame_info_index.h"
+#include "exceptions.h"
+#include "cross.h"
+#include "util.h"
+
+using std::max;
+using std::string;
+using boost::optional;
+
+/** Size of each record in bytes: 8 bytes of offset, 8 bytes of size and a 32-character MD5 hash */
+static int const record_size = 48;
+
+/** @param file Index file, which will be created if it does not exist.
+ *  @param frames Number of frames that we expect to be written (counting each eye
+ *  separately for 3D); the index will grow if more are written.
+ *  @param sync_interval Number of writes to make between syncs to disk.
+ */
+FrameInfoIndex::FrameInfoIndex (boost::filesystem::path file, int frames, int sync_interval)
+	: _path (file)
+	, _file (0)
+	, _capacity (0)
+	, _sync_interval (sync_interval)
+	, _writes_since_sync (0)
+#ifdef DCPOMATIC_POSIX
+	, _map (0)
+#endif
+{
+	if (boost::filesystem::exists (_path)) {
+		_file = fopen_boost (_path, "r+b");
+		_capacity = boost::filesystem::file_size (_path);
+	} else {
+		_file = fopen_boost (_path, "w+b");
+	}
+
+	if (!_file) {
+		throw OpenFileError (_path);
+	}
+
+	int64_t const wanted = max (int64_t (frames), int64_t (1)) * record_size;
+
+#ifdef DCPOMATIC_POSIX
+	if (_capacity > 0) {
+		void* m = mmap (0, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fileno (_file), 0);
+		if (m == MAP_FAILED) {
+			fclose (_file);
+			throw ReadFileError (_path, errno);
+		}
+		_map = static_cast<uint8_t*> (m);
+	}
+#endif
+
+	try {
+		ensure_capacity (wanted);
+	} catch (...) {
+#ifdef DCPOMATIC_POSIX
+		if (_map) {
+			munmap (_map, _capacity);
+		}
+#endif
+		fclose (_file);
+		throw;
+	}
+}
+
+FrameInfoIndex::~FrameInfoIndex ()
+{
+	boost::mutex::scoped_lock lm (_mutex);
+
+	sync_unlocked ();
+#ifdef DCPOMATIC_POSIX
+	if (_map) {
+		munmap (_map, _capacity);
+	}
+#endif
+	fclose (_file);
+}
+
+static int64_t
+position (int frame, Eyes eyes)
+{
+	switch (eyes) {
+	case EYES_BOTH:
+		return int64_t (frame) * record_size;
+	case EYES_LEFT:
+		return int64_t (frame) * record_size * 2;
+	case EYES_RIGHT:
+		return int64_t (frame) * record_size * 2 + record_size;
+	default:
+		DCPOMATIC_ASSERT (false);
+	}
+
+	DCPOMATIC_ASSERT (false);
+}
+
+/** Make sure that the file is at least `bytes' long.  _mutex must be held
+ *  (or the caller must be the constructor).
+ */
+void
+FrameInfoIndex::ensure_capacity (int64_t bytes)
+{
+	if (bytes <= _capacity) {
+		return;
+	}
+
+	/* Grow in big steps so that we don't do this often */
+	int64_t const new_capacity = max (bytes, _capacity * 2);
+
+	/* Nothing here changes _map or _capacity until the new space is ready, so if
+	   something goes wrong we are left as we were.
+	*/
+
+#ifdef DCPOMATIC_POSIX
+	if (ftruncate (fileno (_file), new_capacity) != 0) {
+		throw WriteFileError (_path, errno);
+	}
+
+	void* m = mmap (0, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fileno (_file), 0);
+	if (m == MAP_FAILED) {
+		throw WriteFileError (_path, errno);
+	}
+
+	if (_map) {
+		/* The new mapping shares the same pages, so nothing written to this one is lost */
+		munmap (_map, _capacity);
+	}
+	_map = static_cast<uint8_t*> (m);
+#else
+	/* Fill the new space with zeros, which read() will see as missing frames */
+	uint8_t zero[4096];
+	memset (zero, 0, sizeof (zero));
+	dcpomatic_fseek (_file, _capacity, SEEK_SET);
+	int64_t remaining = new_capacity - _capacity;
+	while (remaining > 0) {
+		int64_t const N = std::min (remaining, int64_t (sizeof (zero)));
+		if (fwrite (zero, 1, N, _file) != size_t (N)) {
+			throw WriteFileError (_path, errno);
+		}
+		remaining -= N;
+	}
+#endif
+
+	_capacity = new_capacity;
+}
+
+/** @return Information about a frame, or none if we have no record of it */
+optional<libdcp::FrameInfo>
+FrameInfoIndex::read (int frame, Eyes eyes) const
+{
+	boost::mutex::scoped_lock lm (_mutex);
+
+	int64_t const p = position (frame, eyes);
+	if ((p + record_size) > _capacity) {
+		return optional<libdcp::FrameInfo> ();
+	}
+
+	uint8_t record[record_size];
+#ifdef DCPOMATIC_POSIX
+	memcpy (record, _map + p, record_size);
+#else
+	dcpomatic_fseek (_file, p, SEEK_SET);
+	if (fread (record, 1, record_size, _file) != size_t (record_size)) {
+		return optional<libdcp::FrameInfo> ();
+	}
+#endif
+
+	uint64_t offset;
+	uint64_t size;
+	memcpy (&offset, record, sizeof (offset));
+	memcpy (&size, record + sizeof (offset), sizeof (size));
+
+	if (size == 0) {
+		/* This record has never been written */
+		return optional<libdcp::FrameInfo> ();
+	}
+
+	return libdcp::FrameInfo (offset, size, string (reinterpret_cast<char *> (record + 16), 32));
+}
+
+void
+FrameInfoIndex::write (int frame, Eyes eyes, libdcp::FrameInfo info)
+{
+	boost::mutex::scoped_lock lm (_mutex);
+
+	int64_t const p = position (frame, eyes);
+	ensure_capacity (p + record_size);
+
+	uint8_t record[record_size];
+	memset (record, 0, record_size);
+	uint64_t const offset = info.offset;
+	uint64_t const size = info.size;
+	memcpy (record, &offset, sizeof (offset));
+	memcpy (record + sizeof (offset), &size, sizeof (size));
+	memcpy (record + 16, info.hash.c_str(), std::min (info.hash.size(), size_t (32)));
+
+#ifdef DCPOMATIC_POSIX
+	memcpy (_map + p, record, record_size);
+#else
+	dcpomatic_fseek (_file, p, SEEK_SET);
+	if (fwrite (record, 1, record_size, _file) != size_t (record_size)) {
+		throw WriteFileError (_path, errno);
+	}
+#endif
+
+	++_writes_since_sync;
+	if (_writes_since_sync >= _sync_interval) {
+		sync_unlocked ();
+	}
+}
+
+/** Make sure everything that has been written is on disk */
+void
+FrameInfoIndex::sync ()
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	sync_unlocked ();
+}
+
+void
+FrameInfoIndex::sync_unlocked ()
+{
+#ifdef DCPOMATIC_POSIX
+	if (_map) {
+		msync (_map, _capacity, MS_SYNC);
+	}
+#else
+	fflush (_file);
+#endif
+	_writes_since_sync = 0;
+}
@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file  src/lib/frame_info_index.h
+ *  @brief FrameInfoIndex class.
+ */
+
+#ifndef DCPOMATIC_FRAME_INFO_INDEX_H
+#define DCPOMATIC_FRAME_INFO_INDEX_H
+
+#include <cstdio>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <libdcp/picture_asset_writer.h>
+#include "types.h"
+
+/** @class FrameInfoIndex
+ *  @brief The file which records where each frame of a film's video MXF is, its size
+ *  and its hash, so that an interrupted encode can be resumed.
+ *
+ *  The file is a set of fixed-size records, one per frame (or one per eye per frame
+ *  for 3D).  On POSIX systems it is memory-mapped, so reading and writing records
+ *  does not need any system calls; changes are sync()ed to disk every `sync_interval'
+ *  writes and when the index is destroyed.
+ *
+ *  This class is thread-safe.
+ */
+class FrameInfoIndex : public boost::noncopyable
+{
+public:
+	FrameInfoIndex (boost::filesystem::path file, int frames, int sync_interval);
+	~FrameInfoIndex ();
+
+	boost::optional<libdcp::FrameInfo> read (int frame, Eyes eyes) const;
+	void write (int frame, Eyes eyes, libdcp::FrameInfo info);
+	void sync ();
+
+private:
+	void ensure_capacity (int64_t bytes);
+	void sync_unlocked ();
+
+	boost::filesystem::path _path;
+	FILE* _file;
+	/** size of the file in bytes */
+	int64_t _capacity;
+	int _sync_interval;
+	/** number of writes since we last sync()ed */
+	int _writes_since_sync;
+#ifdef DCPOMATIC_POSIX
+	/** read-write mapping of the whole file */
+	uint8_t* _map;
+#endif
+	mutable boost::mutex _mutex;
+};
+
+#endif
@@ -487,6 +487,44 @@ Image::write_to_socket (shared_ptr<Socket> socket) const
 }
 
 
+/** @return MD5 digest of the visible pixel data in this image (i.e. ignoring any
+ *  alignment padding at the ends of lines).
+ */
+string
+Image::digest () const
+{
+	MD5Digester digester;
+
+	for (int i = 0; i < components(); ++i) {
+		uint8_t* p = data()[i];
+		for (int y = 0; y < lines(i); ++y) {
+			digester.add (p, line_size()[i]);
+			p += stride()[i];
+		}
+	}
+
+	return digester.get ();
+}
+
+/** @return Digest of every 16th line of this image; two images which are the same
+ *  will always have the same quick digest, but some which are different will too.
+ */
+string
+Image::quick_digest () const
+{
+	MD5Digester digester;
+
+	for (int i = 0; i < components(); ++i) {
+		digester.add (lines (i));
+		digester.add (line_size()[i]);
+		for (int y = 0; y < lines(i); y += 16) {
+			digester.add (data()[i] + y * stride()[i], line_size()[i]);
+		}
+	}
+
+	return digester.get ();
+}
+
 float
 Image::bytes_per_pixel (int c) const
 {
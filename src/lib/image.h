@@ -70,6 +70,9 @@ public:
 	void read_from_socket (boost::shared_ptr<Socket>);
 	void write_to_socket (boost::shared_ptr<Socket>) const;
 
+	std::string digest () const;
+	std::string quick_digest () const;
+
 	AVPixelFormat pixel_format () const {
 		return _pixel_format;
 	}
@@ -26,6 +26,8 @@
 #include "image_proxy.h"
 #include "film.h"
 #include "exceptions.h"
+#include "config.h"
+#include "file_prefetcher.h"
 
 #include "i18n.h"
 
@@ -38,7 +40,10 @@ ImageDecoder::ImageDecoder (shared_ptr<const Film> f, shared_ptr<const ImageCont
 	, VideoDecoder (f, c)
 	, _image_content (c)
 {
-
+	int const depth = Config::instance()->image_prefetch_depth ();
+	if (!_image_content->still () && depth > 0) {
+		_prefetcher.reset (new FilePrefetcher (_image_content->paths (), depth, Config::instance()->image_prefetch_threads ()));
+	}
 }
 
 void
@@ -56,7 +61,11 @@ ImageDecoder::pass ()
 	shared_ptr<const Film> film = _film.lock ();
 	DCPOMATIC_ASSERT (film);
 
-	_image.reset (new MagickImageProxy (_image_content->path (_image_content->still() ? 0 : _video_position), film->log ()));
+	if (_prefetcher) {
+		_image.reset (new MagickImageProxy (_prefetcher->get (_video_position), film->log ()));
+	} else {
+		_image.reset (new MagickImageProxy (_image_content->path (_image_content->still() ? 0 : _video_position), film->log ()));
+	}
 	video (_image, false, _video_position);
 }
 
@@ -24,6 +24,7 @@ namespace Magick {
 }
 
 class ImageContent;
+class FilePrefetcher;
 
 class ImageDecoder : public VideoDecoder
 {
@@ -43,5 +44,7 @@ public:
 private:
 	boost::shared_ptr<const ImageContent> _image_content;
 	boost::shared_ptr<ImageProxy> _image;
+	/** reader of upcoming files in an image sequence, or 0 */
+	boost::shared_ptr<FilePrefetcher> _prefetcher;
 };
 
@@ -19,37 +19,156 @@
 
 #include <iostream>
 #include <Magick++.h>
+#include <boost/thread.hpp>
 #include "image_content.h"
 #include "image_examiner.h"
 #include "film.h"
 #include "job.h"
 #include "exceptions.h"
 #include "config.h"
+#include "compose.hpp"
 
 #include "i18n.h"
 
 using std::cout;
 using std::list;
 using std::sort;
+using std::string;
+using std::min;
+using std::max;
 using boost::shared_ptr;
 using boost::optional;
 
-ImageExaminer::ImageExaminer (shared_ptr<const Film> film, shared_ptr<const ImageContent> content, shared_ptr<Job>)
+ImageExaminer::ImageExaminer (shared_ptr<const Film> film, shared_ptr<const ImageContent> content, shared_ptr<Job> job)
 	: _film (film)
 	, _image_content (content)
 	, _video_length (0)
+	, _next (0)
+	, _done (0)
 {
+	/* Look only at the header of the first file, rather than decoding all of it */
+	optional<ImageHeader> header = read_image_header (content->path (0));
+	if (header) {
+		_video_size = header->size;
+	} else {
+		/* We don't understand this kind of file, so ask ImageMagick, which can
+		   also find out about most formats without decoding them.
+		*/
 #ifdef DCPOMATIC_IMAGE_MAGICK
-	using namespace MagickCore;
+		using namespace MagickCore;
 #endif
-	Magick::Image* image = new Magick::Image (content->path(0).string());
-	_video_size = libdcp::Size (image->columns(), image->rows());
-	delete image;
+		Magick::Image image;
+		image.ping (content->path(0).string());
+		_video_size = libdcp::Size (image.columns(), image.rows());
+	}
 
 	if (content->still ()) {
 		_video_length = Config::instance()->default_still_length() * video_frame_rate().get_value_or (24);
 	} else {
 		_video_length = _image_content->number_of_paths ();
+		if (header && _image_content->number_of_paths() > 1) {
+			check_sequence (header.get (), job);
+		}
+	}
+}
+
+/** Check that every file in our image sequence has the same size and depth as the first,
+ *  so that we find out about any that do not now rather than part-way through a transcode.
+ *  @param first Header of the first file.
+ *  @param job Job to report progress to, or 0.
+ */
+void
+ImageExaminer::check_sequence (ImageHeader first, shared_ptr<Job> job)
+{
+	if (job) {
+		job->sub (_("Checking image sequence"));
+	}
+
+	size_t const N = _image_content->number_of_paths ();
+
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		_next = 1;
+		_done = 1;
+	}
+
+	/* On network storage most of the time is spent waiting, so use a few threads */
+	int const threads = min (int (N - 1), max (4, Config::instance()->num_local_encoding_threads ()));
+
+	boost::thread_group group;
+	for (int i = 0; i < threads; ++i) {
+		group.create_thread (boost::bind (&ImageExaminer::check_thread, this, first));
+	}
+
+	try {
+		while (true) {
+			boost::mutex::scoped_lock lm (_mutex);
+			if (_done == N || _mismatch_index) {
+				break;
+			}
+			_condition.timed_wait (lm, boost::posix_time::milliseconds (250));
+			float const progress = float (_done) / N;
+			lm.unlock ();
+
+			if (job) {
+				job->set_progress (progress);
+			}
+		}
+	} catch (...) {
+		boost::mutex::scoped_lock lm (_mutex);
+		_next = N;
+		lm.unlock ();
+		group.join_all ();
+		throw;
+	}
+
+	{
+		/* Stop as soon as something is wrong */
+		boost::mutex::scoped_lock lm (_mutex);
+		_next = N;
+	}
+
+	group.join_all ();
+
+	if (_mismatch_index) {
+		throw DecodeError (_mismatch);
+	}
+}
+
+/** Thread to check files in our image sequence until there are none left */
+void
+ImageExaminer::check_thread (ImageHeader first)
+{
+	size_t const N = _image_content->number_of_paths ();
+
+	while (true) {
+		boost::mutex::scoped_lock lm (_mutex);
+		if (_next >= N) {
+			return;
+		}
+		size_t const index = _next++;
+		lm.unlock ();
+
+		boost::filesystem::path const p = _image_content->path (index);
+		optional<ImageHeader> h = read_image_header (p);
+
+		string error;
+		if (!h) {
+			error = String::compose (_("Could not read the header of image %1 in the sequence."), p.filename().string());
+		} else if (h->size != first.size || h->depth != first.depth) {
+			error = String::compose (
+				_("Image %1 in the sequence is %2x%3 with %4 bits, but the first image is %5x%6 with %7 bits."),
+				p.filename().string(), h->size.width, h->size.height, h->depth, first.size.width, first.size.height, first.depth
+				);
+		}
+
+		lm.lock ();
+		if (!error.empty () && (!_mismatch_index || index < _mismatch_index.get ())) {
+			_mismatch_index = index;
+			_mismatch = error;
+		}
+		++_done;
+		_condition.notify_all ();
 	}
 }
 
@@ -17,7 +17,10 @@
 
 */
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
 #include "video_examiner.h"
+#include "image_header.h"
 
 namespace Magick {
 	class Image;
@@ -37,8 +40,23 @@ public:
 	}
 
 private:
+	void check_sequence (ImageHeader, boost::shared_ptr<Job>);
+	void check_thread (ImageHeader);
+
 	boost::weak_ptr<const Film> _film;
 	boost::shared_ptr<const ImageContent> _image_content;
 	boost::optional<libdcp::Size> _video_size;
 	VideoContent::Frame _video_length;
+
+	/** mutex for the things below, which are used when checking an image sequence */
+	boost::mutex _mutex;
+	boost::condition _condition;
+	/** index of the next path to check */
+	size_t _next;
+	/** number of paths that have been checked */
+	size_t _done;
+	/** index of the earliest path that is not like the first, if there is one */
+	boost::optional<size_t> _mismatch_index;
+	/** description of what is wrong with the path at _mismatch_index */
+	std::string _mismatch;
 };
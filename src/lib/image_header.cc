@@ -0,0 +1,324 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <cstdio>
+#include <algorithm>
+#include "image_header.h"
+#include "cross.h"
+
+using std::string;
+using std::transform;
+using boost::optional;
+
+/** @class HeaderFile
+ *  @brief A file from which we read numbers of a given endianness at particular offsets.
+ */
+class HeaderFile
+{
+public:
+	HeaderFile (boost::filesystem::path p)
+		: _file (fopen_boost (p, "rb"))
+		, _big_endian (false)
+	{}
+
+	~HeaderFile ()
+	{
+		if (_file) {
+			fclose (_file);
+		}
+	}
+
+	bool ok () const {
+		return _file != 0;
+	}
+
+	void set_big_endian (bool b) {
+		_big_endian = b;
+	}
+
+	bool read (uint64_t offset, uint8_t* buffer, size_t length) {
+		return dcpomatic_fseek (_file, offset, SEEK_SET) == 0 && fread (buffer, 1, length, _file) == length;
+	}
+
+	optional<uint8_t> u8 (uint64_t offset) {
+		uint8_t b;
+		if (!read (offset, &b, 1)) {
+			return optional<uint8_t> ();
+		}
+		return b;
+	}
+
+	optional<uint16_t> u16 (uint64_t offset) {
+		uint8_t b[2];
+		if (!read (offset, b, 2)) {
+			return optional<uint16_t> ();
+		}
+		return _big_endian ? ((b[0] << 8) | b[1]) : ((b[1] << 8) | b[0]);
+	}
+
+	optional<uint32_t> u32 (uint64_t offset) {
+		uint8_t b[4];
+		if (!read (offset, b, 4)) {
+			return optional<uint32_t> ();
+		}
+		if (_big_endian) {
+			return (uint32_t (b[0]) << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+		}
+		return (uint32_t (b[3]) << 24) | (b[2] << 16) | (b[1] << 8) | b[0];
+	}
+
+private:
+	FILE* _file;
+	bool _big_endian;
+};
+
+static optional<ImageHeader>
+dpx_header (HeaderFile& f)
+{
+	optional<uint32_t> magic = f.u32 (0);
+	if (!magic) {
+		return optional<ImageHeader> ();
+	}
+
+	/* Magic is SDPX if the file is big-endian */
+	f.set_big_endian (magic.get() == 0x58504453);
+
+	optional<uint32_t> width = f.u32 (772);
+	optional<uint32_t> height = f.u32 (776);
+	optional<uint8_t> bits = f.u8 (803);
+	if (!width || !height || !bits) {
+		return optional<ImageHeader> ();
+	}
+
+	return ImageHeader (libdcp::Size (width.get(), height.get()), bits.get ());
+}
+
+/** @return Value of a TIFF IFD entry, if it is a SHORT or a LONG */
+static optional<uint32_t>
+tiff_value (HeaderFile& f, uint64_t entry)
+{
+	optional<uint16_t> type = f.u16 (entry + 2);
+	optional<uint32_t> count = f.u32 (entry + 4);
+	if (!type || !count || count.get() == 0) {
+		return optional<uint32_t> ();
+	}
+
+	uint64_t offset = entry + 8;
+	if (type.get() == 3) {
+		if (count.get() > 2) {
+			offset = f.u32(entry + 8).get_value_or (0);
+		}
+		optional<uint16_t> v = f.u16 (offset);
+		return v ? optional<uint32_t> (v.get ()) : optional<uint32_t> ();
+	} else if (type.get() == 4) {
+		if (count.get() > 1) {
+			offset = f.u32(entry + 8).get_value_or (0);
+		}
+		return f.u32 (offset);
+	}
+
+	return optional<uint32_t> ();
+}
+
+static optional<ImageHeader>
+tiff_header (HeaderFile& f)
+{
+	optional<uint8_t> order = f.u8 (0);
+	if (!order) {
+		return optional<ImageHeader> ();
+	}
+
+	f.set_big_endian (order.get() == 'M');
+
+	optional<uint32_t> ifd = f.u32 (4);
+	if (!ifd) {
+		return optional<ImageHeader> ();
+	}
+
+	optional<uint16_t> entries = f.u16 (ifd.get ());
+	if (!entries) {
+		return optional<ImageHeader> ();
+	}
+
+	optional<uint32_t> width;
+	optional<uint32_t> height;
+	/* BitsPerSample defaults to 1 if it is not there */
+	uint32_t bits = 1;
+
+	for (int i = 0; i < entries.get(); ++i) {
+		uint64_t const e = ifd.get() + 2 + i * 12;
+		optional<uint16_t> tag = f.u16 (e);
+		if (!tag) {
+			return optional<ImageHeader> ();
+		}
+
+		switch (tag.get ()) {
+		case 256:
+			width = tiff_value (f, e);
+			break;
+		case 257:
+			height = tiff_value (f, e);
+			break;
+		case 258:
+			bits = tiff_value(f, e).get_value_or (bits);
+			break;
+		}
+	}
+
+	if (!width || !height) {
+		return optional<ImageHeader> ();
+	}
+
+	return ImageHeader (libdcp::Size (width.get(), height.get()), bits);
+}
+
+static optional<ImageHeader>
+png_header (HeaderFile& f)
+{
+	/* The IHDR chunk must come first */
+	f.set_big_endian (true);
+	optional<uint32_t> width = f.u32 (16);
+	optional<uint32_t> height = f.u32 (20);
+	optional<uint8_t> bits = f.u8 (24);
+	if (!width || !height || !bits) {
+		return optional<ImageHeader> ();
+	}
+
+	return ImageHeader (libdcp::Size (width.get(), height.get()), bits.get ());
+}
+
+static optional<ImageHeader>
+jpeg_header (HeaderFile& f)
+{
+	f.set_big_endian (true);
+
+	/* Look through the markers for a start-of-frame */
+	uint64_t offset = 2;
+	while (true) {
+		optional<uint8_t> ff = f.u8 (offset);
+		optional<uint8_t> marker = f.u8 (offset + 1);
+		if (!ff || !marker || ff.get() != 0xff) {
+			return optional<ImageHeader> ();
+		}
+
+		if (marker.get() == 0xff) {
+			/* Padding */
+			++offset;
+			continue;
+		}
+
+		uint8_t const m = marker.get ();
+		if (m >= 0xc0 && m <= 0xcf && m != 0xc4 && m != 0xc8 && m != 0xcc) {
+			optional<uint8_t> bits = f.u8 (offset + 4);
+			optional<uint16_t> height = f.u16 (offset + 5);
+			optional<uint16_t> width = f.u16 (offset + 7);
+			if (!bits || !height || !width) {
+				return optional<ImageHeader> ();
+			}
+			return ImageHeader (libdcp::Size (width.get(), height.get()), bits.get ());
+		}
+
+		if (m == 0xd9 || m == 0xda) {
+			/* End of image or start of scan without a frame header */
+			return optional<ImageHeader> ();
+		}
+
+		optional<uint16_t> length = f.u16 (offset + 2);
+		if (!length) {
+			return optional<ImageHeader> ();
+		}
+		offset += 2 + length.get ();
+	}
+}
+
+static optional<ImageHeader>
+bmp_header (HeaderFile& f)
+{
+	f.set_big_endian (false);
+	optional<uint32_t> width = f.u32 (18);
+	optional<uint32_t> height = f.u32 (22);
+	optional<uint16_t> bits = f.u16 (28);
+	if (!width || !height || !bits) {
+		return optional<ImageHeader> ();
+	}
+
+	/* Height is negative for top-down bitmaps */
+	int32_t const h = static_cast<int32_t> (height.get ());
+	return ImageHeader (libdcp::Size (width.get(), h < 0 ? -h : h), bits.get ());
+}
+
+static optional<ImageHeader>
+tga_header (HeaderFile& f)
+{
+	f.set_big_endian (false);
+	optional<uint16_t> width = f.u16 (12);
+	optional<uint16_t> height = f.u16 (14);
+	optional<uint8_t> bits = f.u8 (16);
+	if (!width || !height || !bits) {
+		return optional<ImageHeader> ();
+	}
+
+	return ImageHeader (libdcp::Size (width.get(), height.get()), bits.get ());
+}
+
+/** Find the size and depth of an image file by looking only at its header.
+ *  @param p Image file.
+ *  @return Header details, or an empty optional if the file is not in a format
+ *  that we understand or its header could not be read.
+ */
+optional<ImageHeader>
+read_image_header (boost::filesystem::path p)
+{
+	HeaderFile f (p);
+	if (!f.ok ()) {
+		return optional<ImageHeader> ();
+	}
+
+	uint8_t m[8];
+	if (!f.read (0, m, 8)) {
+		return optional<ImageHeader> ();
+	}
+
+	optional<ImageHeader> h;
+
+	if ((m[0] == 'S' && m[1] == 'D' && m[2] == 'P' && m[3] == 'X') || (m[0] == 'X' && m[1] == 'P' && m[2] == 'D' && m[3] == 'S')) {
+		h = dpx_header (f);
+	} else if ((m[0] == 'I' && m[1] == 'I' && m[2] == 42 && m[3] == 0) || (m[0] == 'M' && m[1] == 'M' && m[2] == 0 && m[3] == 42)) {
+		h = tiff_header (f);
+	} else if (m[0] == 0x89 && m[1] == 'P' && m[2] == 'N' && m[3] == 'G') {
+		h = png_header (f);
+	} else if (m[0] == 0xff && m[1] == 0xd8) {
+		h = jpeg_header (f);
+	} else if (m[0] == 'B' && m[1] == 'M') {
+		h = bmp_header (f);
+	} else {
+		/* Targa files have no magic number */
+		string ext = p.extension().string ();
+		transform (ext.begin(), ext.end(), ext.begin(), ::tolower);
+		if (ext == ".tga") {
+			h = tga_header (f);
+		}
+	}
+
+	if (h && (h->size.width <= 0 || h->size.height <= 0)) {
+		return optional<ImageHeader> ();
+	}
+
+	return h;
+}
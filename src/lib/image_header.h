@@ -0,0 +1,48 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef DCPOMATIC_IMAGE_HEADER_H
+#define DCPOMATIC_IMAGE_HEADER_H
+
+/** @file  src/lib/image_header.h
+ *  @brief Reading of the size and depth of image files from their headers.
+ */
+
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <libdcp/types.h>
+
+/** @struct ImageHeader
+ *  @brief What we know about an image file without decoding it.
+ */
+struct ImageHeader
+{
+	ImageHeader (libdcp::Size s, int d)
+		: size (s)
+		, depth (d)
+	{}
+
+	libdcp::Size size;
+	/** bits per sample, or per pixel for formats which may use a palette (BMP and Targa) */
+	int depth;
+};
+
+extern boost::optional<ImageHeader> read_image_header (boost::filesystem::path);
+
+#endif
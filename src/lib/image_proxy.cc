@@ -25,6 +25,9 @@
 #include "exceptions.h"
 #include "cross.h"
 #include "log.h"
+#include "md5_digester.h"
+#include "native_image.h"
+#include "file_prefetcher.h"
 
 #include "i18n.h"
 
@@ -79,26 +82,31 @@ RawImageProxy::send_binary (shared_ptr<Socket> socket) const
 	_image->write_to_socket (socket);
 }
 
+string
+RawImageProxy::digest () const
+{
+	return _image->digest ();
+}
+
+string
+RawImageProxy::quick_digest () const
+{
+	return _image->quick_digest ();
+}
+
 MagickImageProxy::MagickImageProxy (boost::filesystem::path path, shared_ptr<Log> log)
 	: ImageProxy (log)
+	, _blob (FilePrefetcher::read (path))
 {
-	/* Read the file into a Blob */
 
-	boost::uintmax_t const size = boost::filesystem::file_size (path);
-	FILE* f = fopen_boost (path, "rb");
-	if (!f) {
-		throw OpenFileError (path);
-	}
+}
 
-	uint8_t* data = new uint8_t[size];
-	if (fread (data, 1, size, f) != size) {
-		delete[] data;
-		throw ReadFileError (path);
-	}
+/** @param blob Contents of an image file */
+MagickImageProxy::MagickImageProxy (Magick::Blob blob, shared_ptr<Log> log)
+	: ImageProxy (log)
+	, _blob (blob)
+{
 
-	fclose (f);
-	_blob.update (data, size);
-	delete[] data;
 }
 
 MagickImageProxy::MagickImageProxy (shared_ptr<cxml::Node>, shared_ptr<Socket> socket, shared_ptr<Log> log)
@@ -120,6 +128,15 @@ MagickImageProxy::image () const
 		return _image;
 	}
 
+	/* Use our own decoders for the formats that they understand; they are much quicker
+	   than ImageMagick and keep the full precision of 10- and 16-bit images.
+	*/
+	_image = decode_native_image (static_cast<uint8_t const *> (_blob.data ()), _blob.length ());
+	if (_image) {
+		LOG_TIMING ("[%1] MagickImageProxy completes native decode of %2 bytes", boost::this_thread::get_id(), _blob.length());
+		return _image;
+	}
+
 	LOG_TIMING ("[%1] MagickImageProxy begins decode and convert of %2 bytes", boost::this_thread::get_id(), _blob.length());
 
 	Magick::Image* magick_image = 0;
@@ -187,6 +204,40 @@ MagickImageProxy::send_binary (shared_ptr<Socket> socket) const
 	socket->write ((uint8_t *) _blob.data (), _blob.length ());
 }
 
+/** @return Digest of the encoded file data; this is much cheaper than
+ *  decoding the image and two identical files will give the same image.
+ */
+string
+MagickImageProxy::digest () const
+{
+	MD5Digester digester;
+	digester.add (_blob.data(), _blob.length());
+	return digester.get ();
+}
+
+string
+MagickImageProxy::quick_digest () const
+{
+	/* Take 64 pieces of 256 bytes from across the file */
+	size_t const pieces = 64;
+	size_t const piece = 256;
+
+	MD5Digester digester;
+	size_t const length = _blob.length ();
+	digester.add (length);
+
+	uint8_t const * data = reinterpret_cast<uint8_t const *> (_blob.data ());
+	if (length <= pieces * piece) {
+		digester.add (data, length);
+	} else {
+		for (size_t i = 0; i < pieces; ++i) {
+			digester.add (data + i * (length - piece) / (pieces - 1), piece);
+		}
+	}
+
+	return digester.get ();
+}
+
 shared_ptr<ImageProxy>
 image_proxy_factory (shared_ptr<cxml::Node> xml, shared_ptr<Socket> socket, shared_ptr<Log> log)
 {
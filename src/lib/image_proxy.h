@@ -56,6 +56,13 @@ public:
 	virtual boost::shared_ptr<Image> image () const = 0;
 	virtual void add_metadata (xmlpp::Node *) const = 0;
 	virtual void send_binary (boost::shared_ptr<Socket>) const = 0;
+	/** @return Digest which is the same for any two proxies that would produce the same image */
+	virtual std::string digest () const = 0;
+	/** @return Digest of part of the image data which is cheap to compute; it is the same for
+	 *  any two proxies that would produce the same image, but may also be the same for some
+	 *  that would not.
+	 */
+	virtual std::string quick_digest () const = 0;
 
 protected:
 	boost::shared_ptr<Log> _log;
@@ -70,6 +77,8 @@ public:
 	boost::shared_ptr<Image> image () const;
 	void add_metadata (xmlpp::Node *) const;
 	void send_binary (boost::shared_ptr<Socket>) const;
+	std::string digest () const;
+	std::string quick_digest () const;
 
 private:
 	boost::shared_ptr<Image> _image;
@@ -79,11 +88,14 @@ class MagickImageProxy : public ImageProxy
 {
 public:
 	MagickImageProxy (boost::filesystem::path, boost::shared_ptr<Log> log);
+	MagickImageProxy (Magick::Blob, boost::shared_ptr<Log> log);
 	MagickImageProxy (boost::shared_ptr<cxml::Node> xml, boost::shared_ptr<Socket> socket, boost::shared_ptr<Log> log);
 
 	boost::shared_ptr<Image> image () const;
 	void add_metadata (xmlpp::Node *) const;
 	void send_binary (boost::shared_ptr<Socket>) const;
+	std::string digest () const;
+	std::string quick_digest () const;
 
 private:
 	Magick::Blob _blob;
@@ -29,6 +29,7 @@
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/signals2.hpp>
 #include <boost/thread.hpp>
+#include "types.h"
 
 class Film;
 
@@ -60,6 +61,11 @@ public:
 	bool finished_cancelled () const;
 	bool paused () const;
 
+	/** @return the resource that this job currently makes most use of */
+	virtual JobResource resource () const {
+		return JOB_RESOURCE_CPU;
+	}
+
 	std::string error_summary () const;
 	std::string error_details () const;
 
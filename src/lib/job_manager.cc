@@ -22,14 +22,17 @@
  */
 
 #include <iostream>
+#include <set>
 #include <boost/thread.hpp>
 #include "job_manager.h"
 #include "job.h"
 #include "cross.h"
 #include "ui_signaller.h"
+#include "config.h"
 
 using std::string;
 using std::list;
+using std::set;
 using std::cout;
 using boost::shared_ptr;
 using boost::weak_ptr;
@@ -116,22 +119,38 @@ JobManager::scheduler ()
 				return;
 			}
 
+			/* Number of running jobs using each resource */
+			int running[JOB_RESOURCE_COUNT];
+			for (int i = 0; i < JOB_RESOURCE_COUNT; ++i) {
+				running[i] = 0;
+			}
+
+			/* Films which have unfinished jobs earlier in the list; a film's jobs
+			   may depend on each other, so they are always run one at a time in order.
+			*/
+			set<shared_ptr<const Film> > busy;
+
 			for (list<shared_ptr<Job> >::iterator i = _jobs.begin(); i != _jobs.end(); ++i) {
 
-				if (!(*i)->finished ()) {
-					active_jobs = true;
+				if ((*i)->finished ()) {
+					continue;
 				}
 
-				if ((*i)->running ()) {
-					/* Something is already happening */
-					break;
+				active_jobs = true;
+
+				shared_ptr<const Film> film = (*i)->film ();
+				bool const film_busy = film && busy.find (film) != busy.end ();
+				if (film) {
+					busy.insert (film);
 				}
 
-				if ((*i)->is_new()) {
-					(*i)->start ();
+				JobResource const resource = (*i)->resource ();
 
-					/* Only start one job at once */
-					break;
+				if ((*i)->running ()) {
+					++running[resource];
+				} else if ((*i)->is_new() && !film_busy && running[resource] < Config::instance()->maximum_jobs (resource)) {
+					(*i)->start ();
+					++running[resource];
 				}
 			}
 		}
@@ -31,6 +31,10 @@ extern void wait_for_jobs ();
 
 /** @class JobManager
  *  @brief A simple scheduler for jobs.
+ *
+ *  Jobs for the same film are run one at a time, in the order that they were added.
+ *  Otherwise, jobs are run at the same time as long as there are not too many
+ *  using the same JobResource (see Config::maximum_jobs).
  */
 class JobManager : public boost::noncopyable
 {
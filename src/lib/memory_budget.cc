@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+
+#include <algorithm>
+#include "memory_budget.h"
+#include "util.h"
+
+using std::max;
+
+MemoryBudget::MemoryBudget (int64_t limit)
+	: _limit (limit)
+	, _total (0)
+	, _total_peak (0)
+{
+	for (int i = 0; i < STAGE_COUNT; ++i) {
+		_used[i] = 0;
+		_peak[i] = 0;
+	}
+}
+
+/** Note that a stage has started to hold some memory */
+void
+MemoryBudget::add (Stage stage, int64_t bytes)
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	_used[stage] += bytes;
+	_total += bytes;
+	_peak[stage] = max (_peak[stage], _used[stage]);
+	_total_peak = max (_total_peak, _total);
+}
+
+/** Note that a stage has released some memory that it was holding */
+void
+MemoryBudget::remove (Stage stage, int64_t bytes)
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	_used[stage] -= bytes;
+	_total -= bytes;
+	DCPOMATIC_ASSERT (_used[stage] >= 0);
+}
+
+/** @param extra Bytes that the caller would like to add.
+ *  @return true if using `extra' more bytes would go over our limit.
+ */
+bool
+MemoryBudget::over (int64_t extra) const
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	return (_total + extra) > _limit;
+}
+
+int64_t
+MemoryBudget::used (Stage stage) const
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	return _used[stage];
+}
+
+/** @return Highest memory use by a stage so far */
+int64_t
+MemoryBudget::peak (Stage stage) const
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	return _peak[stage];
+}
+
+/** @return Highest total memory use so far */
+int64_t
+MemoryBudget::peak () const
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	return _total_peak;
+}
@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+
+/** @file  src/lib/memory_budget.h
+ *  @brief MemoryBudget class.
+ */
+
+#ifndef DCPOMATIC_MEMORY_BUDGET_H
+#define DCPOMATIC_MEMORY_BUDGET_H
+
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+/** @class MemoryBudget
+ *  @brief Account of the memory used by the frames that an encode is holding
+ *  at its various stages, so that the stages can share a limit in bytes.
+ *
+ *  This class is thread-safe.
+ */
+class MemoryBudget : public boost::noncopyable
+{
+public:
+	/** @param limit Limit in bytes */
+	MemoryBudget (int64_t limit);
+
+	enum Stage {
+		/** frames waiting for an encoder thread */
+		ENCODER_QUEUE,
+		/** encoded frames waiting to be written to the MXF */
+		WRITER_QUEUE,
+		STAGE_COUNT
+	};
+
+	void add (Stage stage, int64_t bytes);
+	void remove (Stage stage, int64_t bytes);
+
+	bool over (int64_t extra = 0) const;
+
+	int64_t used (Stage stage) const;
+	int64_t peak (Stage stage) const;
+	int64_t peak () const;
+
+	int64_t limit () const {
+		return _limit;
+	}
+
+private:
+	int64_t const _limit;
+	int64_t _used[STAGE_COUNT];
+	int64_t _total;
+	int64_t _peak[STAGE_COUNT];
+	int64_t _total_peak;
+	mutable boost::mutex _mutex;
+};
+
+#endif
@@ -0,0 +1,414 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <vector>
+#include <boost/optional.hpp>
+#include "native_image.h"
+#include "image.h"
+
+using std::vector;
+using boost::shared_ptr;
+using boost::optional;
+
+/** @class Reader
+ *  @brief Reads numbers of a given endianness from a buffer.
+ */
+class Reader
+{
+public:
+	Reader (uint8_t const * data, size_t size, bool big_endian)
+		: _data (data)
+		, _size (size)
+		, _big_endian (big_endian)
+	{}
+
+	/** @return true if the buffer contains length bytes starting at offset */
+	bool has (uint64_t offset, uint64_t length) const {
+		return offset <= _size && length <= (_size - offset);
+	}
+
+	uint16_t u16 (size_t offset) const {
+		uint8_t const * p = _data + offset;
+		return _big_endian ? ((p[0] << 8) | p[1]) : ((p[1] << 8) | p[0]);
+	}
+
+	uint32_t u32 (size_t offset) const {
+		uint8_t const * p = _data + offset;
+		if (_big_endian) {
+			return (uint32_t (p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+		}
+		return (uint32_t (p[3]) << 24) | (p[2] << 16) | (p[1] << 8) | p[0];
+	}
+
+	uint8_t const * data () const {
+		return _data;
+	}
+
+	bool big_endian () const {
+		return _big_endian;
+	}
+
+private:
+	uint8_t const * _data;
+	size_t _size;
+	bool _big_endian;
+};
+
+/* The loops below are written to be simple enough for the compiler to vectorise:
+   one input word or sample in, a fixed number of output bytes out, no branches.
+   Output is always little-endian 16-bit (for PIX_FMT_RGB48LE) or 8-bit.
+*/
+
+/** Unpack one line of 10-bit RGB which is packed into 32-bit words
+ *  as 10 bits each of R, G and B followed by 2 bits of padding.
+ */
+template <bool big_endian>
+static void
+unpack_10_bit_line (uint8_t const * in, uint8_t* out, int width)
+{
+	for (int x = 0; x < width; ++x) {
+		uint32_t const w = big_endian ?
+			((uint32_t (in[0]) << 24) | (in[1] << 16) | (in[2] << 8) | in[3]) :
+			((uint32_t (in[3]) << 24) | (in[2] << 16) | (in[1] << 8) | in[0]);
+
+		uint32_t const r = (w >> 22) & 0x3ff;
+		uint32_t const g = (w >> 12) & 0x3ff;
+		uint32_t const b = (w >> 2) & 0x3ff;
+
+		/* Scale to 16 bits by repeating the top bits at the bottom */
+		uint32_t const r16 = (r << 6) | (r >> 4);
+		uint32_t const g16 = (g << 6) | (g >> 4);
+		uint32_t const b16 = (b << 6) | (b >> 4);
+
+		out[0] = r16 & 0xff;
+		out[1] = r16 >> 8;
+		out[2] = g16 & 0xff;
+		out[3] = g16 >> 8;
+		out[4] = b16 & 0xff;
+		out[5] = b16 >> 8;
+
+		in += 4;
+		out += 6;
+	}
+}
+
+/** Copy one line of 16-bit samples, taking the first three of every `samples' */
+template <bool big_endian>
+static void
+copy_16_bit_line (uint8_t const * in, uint8_t* out, int width, int samples)
+{
+	int const step = samples * 2;
+	for (int x = 0; x < width; ++x) {
+		for (int c = 0; c < 3; ++c) {
+			out[c * 2] = big_endian ? in[c * 2 + 1] : in[c * 2];
+			out[c * 2 + 1] = big_endian ? in[c * 2] : in[c * 2 + 1];
+		}
+		in += step;
+		out += 6;
+	}
+}
+
+/** Copy one line of 8-bit samples, taking the first three of every `samples' */
+static void
+copy_8_bit_line (uint8_t const * in, uint8_t* out, int width, int samples)
+{
+	for (int x = 0; x < width; ++x) {
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		in += samples;
+		out += 3;
+	}
+}
+
+/** @return Decoded image if data is a DPX file that we understand, otherwise 0 */
+static shared_ptr<Image>
+decode_dpx (uint8_t const * data, size_t size)
+{
+	/* We need the file header and the first image element's header */
+	if (size < 1408) {
+		return shared_ptr<Image> ();
+	}
+
+	bool big_endian;
+	if (data[0] == 'S' && data[1] == 'D' && data[2] == 'P' && data[3] == 'X') {
+		big_endian = true;
+	} else if (data[0] == 'X' && data[1] == 'P' && data[2] == 'D' && data[3] == 'S') {
+		big_endian = false;
+	} else {
+		return shared_ptr<Image> ();
+	}
+
+	Reader r (data, size, big_endian);
+
+	int const elements = r.u16 (770);
+	int const width = r.u32 (772);
+	int const height = r.u32 (776);
+	uint8_t const descriptor = data[800];
+	uint8_t const bits = data[803];
+	int const packing = r.u16 (804);
+	int const encoding = r.u16 (806);
+	uint64_t offset = r.u32 (808);
+	uint64_t line_padding = r.u32 (812);
+
+	if (offset == 0 || offset == 0xffffffff) {
+		offset = r.u32 (4);
+	}
+
+	if (line_padding == 0xffffffff) {
+		line_padding = 0;
+	}
+
+	/* We only do uncompressed RGB, either 10-bit packed into 32-bit words or 16-bit */
+	if (elements < 1 || width <= 0 || height <= 0 || descriptor != 50 || encoding != 0) {
+		return shared_ptr<Image> ();
+	}
+
+	uint64_t line_bytes = 0;
+	if (bits == 10 && packing == 1) {
+		line_bytes = uint64_t (width) * 4;
+	} else if (bits == 16) {
+		line_bytes = uint64_t (width) * 6;
+		if (packing == 1) {
+			line_bytes = (line_bytes + 3) & ~3;
+		}
+	} else {
+		return shared_ptr<Image> ();
+	}
+
+	uint64_t const line_stride = line_bytes + line_padding;
+	if (!r.has (offset, line_stride * (height - 1) + line_bytes)) {
+		return shared_ptr<Image> ();
+	}
+
+	shared_ptr<Image> image (new Image (PIX_FMT_RGB48LE, libdcp::Size (width, height), true));
+
+	uint8_t const * in = data + offset;
+	uint8_t* out = image->data()[0];
+	for (int y = 0; y < height; ++y) {
+		if (bits == 10) {
+			if (big_endian) {
+				unpack_10_bit_line<true> (in, out, width);
+			} else {
+				unpack_10_bit_line<false> (in, out, width);
+			}
+		} else {
+			if (big_endian) {
+				copy_16_bit_line<true> (in, out, width, 3);
+			} else {
+				copy_16_bit_line<false> (in, out, width, 3);
+			}
+		}
+		in += line_stride;
+		out += image->stride()[0];
+	}
+
+	return image;
+}
+
+/** @return Value number index of a TIFF IFD entry, if it is there and is a SHORT or a LONG */
+static optional<uint32_t>
+tiff_value (Reader const & r, size_t entry, uint32_t index)
+{
+	int const type = r.u16 (entry + 2);
+	uint32_t const count = r.u32 (entry + 4);
+	if (index >= count || (type != 3 && type != 4)) {
+		return optional<uint32_t> ();
+	}
+
+	int const type_size = type == 3 ? 2 : 4;
+	uint64_t offset = entry + 8;
+	if (uint64_t (count) * type_size > 4) {
+		/* The values are elsewhere */
+		offset = r.u32 (entry + 8);
+	}
+	offset += uint64_t (index) * type_size;
+
+	if (!r.has (offset, type_size)) {
+		return optional<uint32_t> ();
+	}
+
+	return type == 3 ? r.u16 (offset) : r.u32 (offset);
+}
+
+/** @return Decoded image if data is a TIFF file that we understand, otherwise 0 */
+static shared_ptr<Image>
+decode_tiff (uint8_t const * data, size_t size)
+{
+	if (size < 8) {
+		return shared_ptr<Image> ();
+	}
+
+	bool big_endian;
+	if (data[0] == 'I' && data[1] == 'I' && data[2] == 42 && data[3] == 0) {
+		big_endian = false;
+	} else if (data[0] == 'M' && data[1] == 'M' && data[2] == 0 && data[3] == 42) {
+		big_endian = true;
+	} else {
+		return shared_ptr<Image> ();
+	}
+
+	Reader r (data, size, big_endian);
+
+	uint64_t const ifd = r.u32 (4);
+	if (!r.has (ifd, 2)) {
+		return shared_ptr<Image> ();
+	}
+
+	int const entries = r.u16 (ifd);
+	if (!r.has (ifd + 2, uint64_t (entries) * 12)) {
+		return shared_ptr<Image> ();
+	}
+
+	optional<uint32_t> width;
+	optional<uint32_t> height;
+	uint32_t compression = 1;
+	optional<uint32_t> photometric;
+	uint32_t samples = 1;
+	uint32_t planar = 1;
+	uint32_t sample_format = 1;
+	optional<uint32_t> rows_per_strip;
+	optional<size_t> bits_entry;
+	optional<size_t> offsets_entry;
+	optional<size_t> counts_entry;
+
+	for (int i = 0; i < entries; ++i) {
+		size_t const e = ifd + 2 + i * 12;
+		switch (r.u16 (e)) {
+		case 256:
+			width = tiff_value (r, e, 0);
+			break;
+		case 257:
+			height = tiff_value (r, e, 0);
+			break;
+		case 258:
+			bits_entry = e;
+			break;
+		case 259:
+			compression = tiff_value(r, e, 0).get_value_or (0);
+			break;
+		case 262:
+			photometric = tiff_value (r, e, 0);
+			break;
+		case 273:
+			offsets_entry = e;
+			break;
+		case 277:
+			samples = tiff_value(r, e, 0).get_value_or (0);
+			break;
+		case 278:
+			rows_per_strip = tiff_value (r, e, 0);
+			break;
+		case 279:
+			counts_entry = e;
+			break;
+		case 284:
+			planar = tiff_value(r, e, 0).get_value_or (0);
+			break;
+		case 339:
+			sample_format = tiff_value(r, e, 0).get_value_or (0);
+			break;
+		}
+	}
+
+	/* We only do uncompressed, interleaved, unsigned-integer RGB(A) */
+	if (
+		!width || !height || width.get() == 0 || height.get() == 0 || !bits_entry || !offsets_entry ||
+		compression != 1 || !photometric || photometric.get() != 2 || planar != 1 || sample_format != 1 ||
+		samples < 3 || samples > 4
+		) {
+		return shared_ptr<Image> ();
+	}
+
+	optional<uint32_t> const bits = tiff_value (r, bits_entry.get(), 0);
+	if (!bits || (bits.get() != 8 && bits.get() != 16)) {
+		return shared_ptr<Image> ();
+	}
+
+	for (uint32_t i = 1; i < samples; ++i) {
+		if (tiff_value (r, bits_entry.get(), i) != bits) {
+			return shared_ptr<Image> ();
+		}
+	}
+
+	uint32_t const rows = rows_per_strip.get_value_or (height.get ());
+	if (rows == 0) {
+		return shared_ptr<Image> ();
+	}
+
+	uint64_t const line_bytes = uint64_t (width.get()) * samples * bits.get() / 8;
+	if (line_bytes * height.get() > size) {
+		/* This can't be uncompressed */
+		return shared_ptr<Image> ();
+	}
+
+	shared_ptr<Image> image (
+		new Image (bits.get() == 8 ? PIX_FMT_RGB24 : PIX_FMT_RGB48LE, libdcp::Size (width.get(), height.get()), true)
+		);
+
+	uint8_t* out = image->data()[0];
+	for (uint32_t y = 0; y < height.get(); ++y) {
+		uint32_t const strip = y / rows;
+		optional<uint32_t> const strip_offset = tiff_value (r, offsets_entry.get(), strip);
+		if (!strip_offset) {
+			return shared_ptr<Image> ();
+		}
+
+		uint64_t const offset = strip_offset.get() + uint64_t (y % rows) * line_bytes;
+		if (!r.has (offset, line_bytes)) {
+			return shared_ptr<Image> ();
+		}
+
+		if (counts_entry) {
+			optional<uint32_t> const count = tiff_value (r, counts_entry.get(), strip);
+			if (count && (offset + line_bytes) > (strip_offset.get() + uint64_t (count.get ()))) {
+				return shared_ptr<Image> ();
+			}
+		}
+
+		uint8_t const * in = data + offset;
+		if (bits.get() == 8) {
+			copy_8_bit_line (in, out, width.get(), samples);
+		} else if (big_endian) {
+			copy_16_bit_line<true> (in, out, width.get(), samples);
+		} else {
+			copy_16_bit_line<false> (in, out, width.get(), samples);
+		}
+
+		out += image->stride()[0];
+	}
+
+	return image;
+}
+
+/** Try to decode an image file using our own decoders.
+ *  @param data File data.
+ *  @param size Size of data in bytes.
+ *  @return Image (which is aligned), or 0 if the file is not in a format that we can decode.
+ */
+shared_ptr<Image>
+decode_native_image (uint8_t const * data, size_t size)
+{
+	shared_ptr<Image> image = decode_dpx (data, size);
+	if (!image) {
+		image = decode_tiff (data, size);
+	}
+
+	return image;
+}
@@ -0,0 +1,39 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef DCPOMATIC_NATIVE_IMAGE_H
+#define DCPOMATIC_NATIVE_IMAGE_H
+
+/** @file  src/lib/native_image.h
+ *  @brief Our own decoders for some image file formats.
+ *
+ *  These understand uncompressed RGB DPX (10-bit packed or 16-bit) and
+ *  uncompressed RGB TIFF (8- or 16-bit), which are common in image sequences.
+ *  They are much quicker than going via ImageMagick and they keep the full
+ *  precision of 10- and 16-bit images.
+ */
+
+#include <boost/shared_ptr.hpp>
+#include <stdint.h>
+
+class Image;
+
+extern boost::shared_ptr<Image> decode_native_image (uint8_t const * data, size_t size);
+
+#endif
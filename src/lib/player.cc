@@ -44,6 +44,7 @@
 
 using std::list;
 using std::cout;
+using std::string;
 using std::min;
 using std::max;
 using std::vector;
@@ -325,21 +326,12 @@ Player::process_audio (
 	shared_ptr<AudioContent> content = dynamic_pointer_cast<AudioContent> (piece->content);
 	DCPOMATIC_ASSERT (content);
 
-	if (!already_resampled) {
-		/* Gain */
-		if (content->audio_gain() != 0) {
-			shared_ptr<AudioBuffers> gain (new AudioBuffers (audio));
-			gain->apply_gain (content->audio_gain ());
-			audio = gain;
-		}
-
-		/* Resample */
-		if (stream->frame_rate() != content->output_audio_frame_rate()) {
-			shared_ptr<Resampler> r = resampler (content, stream, true);
-			pair<shared_ptr<const AudioBuffers>, AudioContent::Frame> ro = r->run (audio, frame);
-			audio = ro.first;
-			frame = ro.second;
-		}
+	/* Resample */
+	if (!already_resampled && stream->frame_rate() != content->output_audio_frame_rate()) {
+		shared_ptr<Resampler> r = resampler (content, stream, true);
+		pair<shared_ptr<const AudioBuffers>, AudioContent::Frame> ro = r->run (audio, frame);
+		audio = ro.first;
+		frame = ro.second;
 	}
 
 	Time const relative_time = _film->audio_frames_to_time (frame);
@@ -351,24 +343,11 @@ Player::process_audio (
 	/* Compute time in the DCP */
 	Time time = content->position() + (content->audio_delay() * TIME_HZ / 1000) + relative_time - content->trim_start ();
 
-	/* Remap channels */
+	/* Remap channels and apply gain.  Since resampling is linear it does not
+	   matter that we do this after the resampler rather than before.
+	*/
 	shared_ptr<AudioBuffers> dcp_mapped (new AudioBuffers (_film->audio_channels(), audio->frames()));
-	dcp_mapped->make_silent ();
-
-	AudioMapping map = stream->mapping ();
-	for (int i = 0; i < map.content_channels(); ++i) {
-		for (int j = 0; j < dcp_mapped->channels(); ++j) {
-			if (map.get (i, static_cast<libdcp::Channel> (j)) > 0) {
-				dcp_mapped->accumulate_channel (
-					audio.get(),
-					i,
-					static_cast<libdcp::Channel> (j),
-					map.get (i, static_cast<libdcp::Channel> (j))
-					);
-			}
-		}
-	}
-
+	mixing_plan(content, stream)->run (audio.get(), dcp_mapped.get());
 	audio = dcp_mapped;
 
 	/* We must cut off anything that comes before the start of all time */
@@ -378,10 +357,7 @@ Player::process_audio (
 			return;
 		}
 
-		shared_ptr<AudioBuffers> trimmed (new AudioBuffers (audio->channels(), audio->frames() - frames));
-		trimmed->copy_from (audio.get(), audio->frames() - frames, frames, 0);
-
-		audio = trimmed;
+		audio = audio->view (frames, audio->frames() - frames);
 		time = 0;
 	}
 
@@ -570,6 +546,13 @@ Player::content_changed (weak_ptr<Content> w, int property, bool frequent)
 
 		Changed (frequent);
 
+	} else if (
+		property == AudioContentProperty::AUDIO_MAPPING || property == AudioContentProperty::AUDIO_GAIN ||
+		property == AudioContentProperty::AUDIO_CHANNELS || property == FFmpegContentProperty::AUDIO_STREAMS
+		) {
+
+		_mixing_plans.clear ();
+
 	} else if (property == ContentProperty::PATH) {
 
 		_have_valid_pieces = false;
@@ -604,6 +587,8 @@ Player::set_video_container_size (libdcp::Size s)
 			ColourConversion ()
 			)
 		);
+
+	_black_frame->set_black ();
 }
 
 shared_ptr<Resampler>
@@ -633,6 +618,23 @@ Player::resampler (shared_ptr<AudioContent> content, AudioStreamPtr stream, bool
 	return r;
 }
 
+/** @return Plan for mixing audio from a stream into our DCP channels; plans are
+ *  thrown away by content_changed() and film_changed() when anything they were
+ *  made from changes.
+ */
+shared_ptr<const AudioMixingPlan>
+Player::mixing_plan (shared_ptr<const AudioContent> content, AudioStreamPtr stream)
+{
+	map<AudioStreamPtr, shared_ptr<AudioMixingPlan> >::iterator i = _mixing_plans.find (stream);
+	if (i != _mixing_plans.end()) {
+		return i->second;
+	}
+
+	shared_ptr<AudioMixingPlan> p (new AudioMixingPlan (stream->mapping (), content->audio_gain(), _film->audio_channels()));
+	_mixing_plans[stream] = p;
+	return p;
+}
+
 void
 Player::emit_black ()
 {
@@ -669,6 +671,8 @@ Player::film_changed (Film::Property p)
 
 	if (p == Film::SCALER || p == Film::WITH_SUBTITLES || p == Film::CONTAINER || p == Film::VIDEO_FRAME_RATE) {
 		Changed (false);
+	} else if (p == Film::AUDIO_CHANNELS) {
+		_mixing_plans.clear ();
 	}
 }
 
@@ -98,6 +98,7 @@ private:
 	void emit_black ();
 	void emit_silence (OutputAudioFrame);
 	boost::shared_ptr<Resampler> resampler (boost::shared_ptr<AudioContent>, AudioStreamPtr stream, bool);
+	boost::shared_ptr<const AudioMixingPlan> mixing_plan (boost::shared_ptr<const AudioContent>, AudioStreamPtr stream);
 	void film_changed (Film::Property);
 	void update_subtitle ();
 
@@ -122,6 +123,7 @@ private:
 	libdcp::Size _video_container_size;
 	boost::shared_ptr<PlayerVideoFrame> _black_frame;
 	std::map<std::pair<boost::shared_ptr<AudioContent>, AudioStreamPtr>, boost::shared_ptr<Resampler> > _resamplers;
+	std::map<AudioStreamPtr, boost::shared_ptr<AudioMixingPlan> > _mixing_plans;
 
 	std::list<Subtitle> _subtitles;
 
@@ -22,6 +22,7 @@
 #include "image.h"
 #include "image_proxy.h"
 #include "scaler.h"
+#include "md5_digester.h"
 
 using std::string;
 using std::cout;
@@ -45,11 +46,13 @@ PlayerVideoFrame::PlayerVideoFrame (
 	, _eyes (eyes)
 	, _part (part)
 	, _colour_conversion (colour_conversion)
+	, _black (false)
 {
 
 }
 
 PlayerVideoFrame::PlayerVideoFrame (shared_ptr<cxml::Node> node, shared_ptr<Socket> socket, shared_ptr<Log> log)
+	: _black (false)
 {
 	_crop = Crop (node);
 
@@ -150,3 +153,57 @@ PlayerVideoFrame::send_binary (shared_ptr<Socket> socket) const
 		_subtitle_image->write_to_socket (socket);
 	}
 }
+
+/** @return Digest of everything that goes into making this frame's output image;
+ *  two frames with the same digest will give the same image.
+ */
+string
+PlayerVideoFrame::digest () const
+{
+	return digest (_in->digest ());
+}
+
+/** @return Digest like that from digest(), but made from a quick digest of the input image,
+ *  so two frames with different quick digests will always give different images, but
+ *  two with the same one might not.
+ */
+string
+PlayerVideoFrame::quick_digest () const
+{
+	return digest (_in->quick_digest ());
+}
+
+/** @param in Digest of our input image.
+ *  @return Digest of that and everything else that goes into making our output image.
+ */
+string
+PlayerVideoFrame::digest (string in) const
+{
+	MD5Digester digester;
+
+	digester.add (in.c_str(), in.length());
+	digester.add (_crop.left);
+	digester.add (_crop.right);
+	digester.add (_crop.top);
+	digester.add (_crop.bottom);
+	digester.add (_inter_size.width);
+	digester.add (_inter_size.height);
+	digester.add (_out_size.width);
+	digester.add (_out_size.height);
+	digester.add (_scaler->id().c_str(), _scaler->id().length());
+	digester.add (_part);
+
+	if (_colour_conversion) {
+		string const c = _colour_conversion.get().identifier ();
+		digester.add (c.c_str(), c.length());
+	}
+
+	if (_subtitle_image) {
+		string const s = _subtitle_image->digest ();
+		digester.add (s.c_str(), s.length());
+		digester.add (_subtitle_position.x);
+		digester.add (_subtitle_position.y);
+	}
+
+	return digester.get ();
+}
@@ -43,11 +43,19 @@ public:
 
 	void set_subtitle (boost::shared_ptr<const Image>, Position<int>);
 
+	/** Note that this frame is entirely black */
+	void set_black () {
+		_black = true;
+	}
+
 	boost::shared_ptr<Image> image (AVPixelFormat) const;
 
 	void add_metadata (xmlpp::Node* node) const;
 	void send_binary (boost::shared_ptr<Socket> socket) const;
 
+	std::string digest () const;
+	std::string quick_digest () const;
+
 	Eyes eyes () const {
 		return _eyes;
 	}
@@ -56,7 +64,18 @@ public:
 		return _colour_conversion;
 	}
 
+	libdcp::Size out_size () const {
+		return _out_size;
+	}
+
+	/** @return true if this frame is known to be entirely black */
+	bool black () const {
+		return _black;
+	}
+
 private:
+	std::string digest (std::string) const;
+
 	boost::shared_ptr<const ImageProxy> _in;
 	Crop _crop;
 	libdcp::Size _inter_size;
@@ -67,4 +86,5 @@ private:
 	boost::optional<ColourConversion> _colour_conversion;
 	boost::shared_ptr<const Image> _subtitle_image;
 	Position<int> _subtitle_position;
+	bool _black;
 };
@@ -156,6 +156,16 @@ Playlist::add (shared_ptr<Content> c)
 	Changed ();
 }
 
+/** Add several pieces of content, with a single notification of the change */
+void
+Playlist::add (ContentList c)
+{
+	_content.insert (_content.end(), c.begin(), c.end());
+	sort (_content.begin(), _content.end(), ContentSorter ());
+	reconnect ();
+	Changed ();
+}
+
 void
 Playlist::remove (shared_ptr<Content> c)
 {
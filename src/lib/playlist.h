@@ -61,6 +61,7 @@ public:
 
 	void add (boost::shared_ptr<Content>);
 	void remove (boost::shared_ptr<Content>);
+	void add (ContentList);
 	void remove (ContentList);
 	void move_earlier (boost::shared_ptr<Content>);
 	void move_later (boost::shared_ptr<Content>);
@@ -33,6 +33,10 @@ public:
 	void run ();
 	std::string status () const;
 
+	JobResource resource () const {
+		return JOB_RESOURCE_NETWORK;
+	}
+
 private:
 	void set_status (std::string);
 
@@ -39,6 +39,10 @@ public:
 	std::string json_name () const;
 	void run ();
 
+	JobResource resource () const {
+		return JOB_RESOURCE_NETWORK;
+	}
+
 private:
 	std::list<boost::shared_ptr<Screen> > _screens;
 	boost::filesystem::path _dcp;
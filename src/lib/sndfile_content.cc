@@ -79,7 +79,9 @@ SndfileContent::valid_file (boost::filesystem::path f)
 void
 SndfileContent::examine (shared_ptr<Job> job)
 {
-	job->set_progress_unknown ();
+	if (job) {
+		job->set_progress_unknown ();
+	}
 	Content::examine (job);
 
 	shared_ptr<const Film> film = _film.lock ();
@@ -28,6 +28,7 @@
 #include "film.h"
 #include "exceptions.h"
 #include "audio_buffers.h"
+#include "audio_convert.h"
 
 #include "i18n.h"
 
@@ -78,7 +79,11 @@ SndfileDecoder::pass ()
 
 	int const channels = _sndfile_content->audio_channels ();
 
-	shared_ptr<AudioBuffers> data (new AudioBuffers (channels, this_time));
+	/* Re-use our buffers if nobody kept hold of the last ones */
+	if (!_data || !_data.unique ()) {
+		_data.reset (new AudioBuffers (channels, block));
+	}
+	shared_ptr<AudioBuffers> data = _data;
 
 	if (_sndfile_content->audio_channels() == 1) {
 		/* No de-interleaving required */
@@ -89,16 +94,7 @@ SndfileDecoder::pass ()
 			_deinterleave_buffer = new float[block * channels];
 		}
 		sf_readf_float (_sndfile, _deinterleave_buffer, this_time);
-		vector<float*> out_ptr (channels);
-		for (int i = 0; i < channels; ++i) {
-			out_ptr[i] = data->data(i);
-		}
-		float* in_ptr = _deinterleave_buffer;
-		for (int i = 0; i < this_time; ++i) {
-			for (int j = 0; j < channels; ++j) {
-				*out_ptr[j]++ = *in_ptr++;
-			}
-		}
+		deinterleave_samples (_deinterleave_buffer, channels, this_time, data->data ());
 	}
 
 	data->set_frames (this_time);
@@ -22,6 +22,7 @@
 #include "audio_decoder.h"
 
 class SndfileContent;
+class AudioBuffers;
 
 class SndfileDecoder : public AudioDecoder
 {
@@ -43,4 +44,6 @@ private:
 	AudioContent::Frame _done;
 	AudioContent::Frame _remaining;
 	float* _deinterleave_buffer;
+	/** buffers that we last emitted */
+	boost::shared_ptr<AudioBuffers> _data;
 };
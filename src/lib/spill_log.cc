@@ -0,0 +1,241 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <cerrno>
+#ifdef DCPOMATIC_LINUX
+#include <fcntl.h>
+#endif
+#ifdef DCPOMATIC_POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include "spill_log.h"
+#include "dcp_video_frame.h"
+#include "exceptions.h"
+#include "cross.h"
+
+#include "i18n.h"
+
+using std::map;
+using std::min;
+using std::max;
+using std::make_pair;
+using boost::shared_ptr;
+
+/** Amount of disk space to reserve at a time as a segment grows, in bytes */
+static int64_t const reserve_step = 16 * 1024 * 1024;
+
+/** @class SpillSegment
+ *  @brief One file of a SpillLog, which is removed when the SpillSegment is destroyed.
+ *
+ *  The file starts empty and grows as frames are appended, up to a fixed capacity;
+ *  disk space is reserved a piece at a time ahead of the writes.
+ */
+class SpillSegment : public boost::noncopyable
+{
+public:
+	SpillSegment (boost::filesystem::path path, int64_t capacity)
+		: _path (path)
+		, _capacity (capacity)
+		, _length (0)
+#ifdef DCPOMATIC_LINUX
+		, _reserved (0)
+#endif
+#ifdef DCPOMATIC_POSIX
+		, _map (0)
+#endif
+	{
+		_file = fopen_boost (_path, "w+b");
+		if (!_file) {
+			throw OpenFileError (_path);
+		}
+
+#ifdef DCPOMATIC_POSIX
+		/* Map the whole capacity now so that the mapping never has to move; only the
+		   part that has been written (and so is inside the file) is ever read.
+		*/
+		void* m = mmap (0, _capacity, PROT_READ, MAP_SHARED, fileno (_file), 0);
+		if (m == MAP_FAILED) {
+			int const e = errno;
+			close ();
+			throw ReadFileError (_path, e);
+		}
+		_map = static_cast<uint8_t *> (m);
+#endif
+	}
+
+	~SpillSegment ()
+	{
+#ifdef DCPOMATIC_POSIX
+		munmap (_map, _capacity);
+#endif
+		close ();
+	}
+
+	/** @return true if there is room in this segment for a frame of `size' bytes */
+	bool has_room (int size) const {
+		return (_length + size) <= _capacity;
+	}
+
+	/** Append some data to the end of this segment.
+	 *  @return Offset of the data within the segment.
+	 */
+	int64_t append (uint8_t const * data, int size)
+	{
+#ifdef DCPOMATIC_LINUX
+		if (_length + size > _reserved) {
+			/* Try to reserve some more space so that the file is laid out in big pieces;
+			   it does not matter if the filesystem does not support this.
+			*/
+			int64_t const step = min (_capacity - _reserved, max (int64_t (size), reserve_step));
+			fallocate (fileno (_file), FALLOC_FL_KEEP_SIZE, _reserved, step);
+			_reserved += step;
+		}
+#endif
+
+		int64_t const offset = _length;
+		if (fwrite (data, 1, size, _file) != size_t (size) || fflush (_file) != 0) {
+			throw WriteFileError (_path, errno);
+		}
+		_length += size;
+		return offset;
+	}
+
+#ifdef DCPOMATIC_POSIX
+	uint8_t* mapping () const {
+		return _map;
+	}
+#endif
+
+	/** Read some data back from this segment into a new EncodedData */
+	shared_ptr<EncodedData> read (int64_t offset, int size)
+	{
+		shared_ptr<EncodedData> data (new EncodedData (size));
+		dcpomatic_fseek (_file, offset, SEEK_SET);
+		size_t const r = fread (data->data(), 1, size, _file);
+		dcpomatic_fseek (_file, _length, SEEK_SET);
+		if (r != size_t (size)) {
+			throw ReadFileError (_path, errno);
+		}
+		return data;
+	}
+
+private:
+	void close ()
+	{
+		fclose (_file);
+		boost::system::error_code ec;
+		boost::filesystem::remove (_path, ec);
+	}
+
+	boost::filesystem::path _path;
+	FILE* _file;
+	int64_t _capacity;
+	/** number of bytes that have been written */
+	int64_t _length;
+#ifdef DCPOMATIC_LINUX
+	/** number of bytes that we have asked the filesystem to reserve */
+	int64_t _reserved;
+#endif
+#ifdef DCPOMATIC_POSIX
+	/** read-only mapping of the whole of _capacity, of which only the first _length bytes may be read */
+	uint8_t* _map;
+#endif
+};
+
+#ifdef DCPOMATIC_POSIX
+
+/** @class MappedEncodedData
+ *  @brief EncodedData which points into a SpillSegment's mapping, and keeps
+ *  the segment alive for as long as it is needed.
+ */
+class MappedEncodedData : public EncodedData
+{
+public:
+	MappedEncodedData (shared_ptr<SpillSegment> segment, int64_t offset, int size)
+		: _segment (segment)
+	{
+		_data = segment->mapping() + offset;
+		_size = size;
+	}
+
+	~MappedEncodedData ()
+	{
+		/* Our data belongs to the mapping, so stop ~EncodedData from deleting it */
+		_data = 0;
+	}
+
+private:
+	shared_ptr<SpillSegment> _segment;
+};
+
+#endif
+
+/** @param directory Directory to write segment files to; any existing contents will be removed.
+ *  @param segment_size Maximum size of each segment file, in bytes, unless a single frame is bigger.
+ */
+SpillLog::SpillLog (boost::filesystem::path directory, int64_t segment_size)
+	: _directory (directory)
+	, _segment_size (segment_size)
+	, _segments_created (0)
+{
+	/* Anything left over from a previous run is of no use to us */
+	boost::filesystem::remove_all (_directory);
+	boost::filesystem::create_directories (_directory);
+}
+
+void
+SpillLog::write (shared_ptr<const EncodedData> data, int frame, Eyes eyes)
+{
+	if (!_current || !_current->has_room (data->size ())) {
+		/* Finished segments stay alive for as long as there are frames in them
+		   which have not been read back.
+		*/
+		_current.reset (
+			new SpillSegment (
+				_directory / String::compose ("%1.spill", _segments_created),
+				max (_segment_size, int64_t (data->size ()))
+				)
+			);
+		++_segments_created;
+	}
+
+	Record r;
+	r.segment = _current;
+	r.offset = _current->append (data->data(), data->size());
+	r.size = data->size ();
+	_index[make_pair (frame, eyes)] = r;
+}
+
+/** Read a frame back from the log.  Each frame can only be read once. */
+shared_ptr<const EncodedData>
+SpillLog::read (int frame, Eyes eyes)
+{
+	map<std::pair<int, Eyes>, Record>::iterator i = _index.find (make_pair (frame, eyes));
+	DCPOMATIC_ASSERT (i != _index.end ());
+
+	Record r = i->second;
+	_index.erase (i);
+
+#ifdef DCPOMATIC_POSIX
+	return shared_ptr<const EncodedData> (new MappedEncodedData (r.segment, r.offset, r.size));
+#else
+	return r.segment->read (r.offset, r.size);
+#endif
+}
@@ -0,0 +1,75 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file  src/lib/spill_log.h
+ *  @brief SpillLog class.
+ */
+
+#ifndef DCPOMATIC_SPILL_LOG_H
+#define DCPOMATIC_SPILL_LOG_H
+
+#include <map>
+#include <boost/shared_ptr.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+#include "types.h"
+
+class EncodedData;
+class SpillSegment;
+
+/** @class SpillLog
+ *  @brief A place for the Writer to put JPEG2000 frames which it cannot yet
+ *  write to the MXF and has no room to keep in memory.
+ *
+ *  Frames are appended to segment files, which grow as needed up to a maximum
+ *  size, and an index of where each frame is is kept in memory.  A segment file
+ *  is removed once all the frames in it have been read back.  On POSIX systems
+ *  the segments are memory-mapped so that frames can be read back without copying.
+ *
+ *  Spilled frames are only needed until they are written to the MXF, so none of this
+ *  survives a restart; resuming an interrupted encode uses the MXF and its info file.
+ *
+ *  This class is not thread-safe.
+ */
+class SpillLog : public boost::noncopyable
+{
+public:
+	SpillLog (boost::filesystem::path directory, int64_t segment_size);
+
+	void write (boost::shared_ptr<const EncodedData> data, int frame, Eyes eyes);
+	boost::shared_ptr<const EncodedData> read (int frame, Eyes eyes);
+
+private:
+	struct Record
+	{
+		boost::shared_ptr<SpillSegment> segment;
+		int64_t offset;
+		int size;
+	};
+
+	boost::filesystem::path _directory;
+	int64_t _segment_size;
+	int _segments_created;
+	/** the segment that we are currently appending to, or 0 */
+	boost::shared_ptr<SpillSegment> _current;
+	/** where each frame is, keyed on frame index and eyes */
+	std::map<std::pair<int, Eyes>, Record> _index;
+};
+
+#endif
@@ -66,31 +66,55 @@ TranscodeJob::run ()
 
 		LOG_GENERAL_NC (N_("Transcode job starting"));
 
-		_transcoder.reset (new Transcoder (_film, shared_from_this ()));
-		_transcoder->go ();
+		shared_ptr<Transcoder> t (new Transcoder (_film, shared_from_this ()));
+		set_transcoder (t);
+		t->go ();
 		set_progress (1);
 		set_state (FINISHED_OK);
 
 		LOG_GENERAL_NC (N_("Transcode job completed successfully"));
-		_transcoder.reset ();
+		set_transcoder (shared_ptr<Transcoder> ());
 
 	} catch (...) {
 		set_progress (1);
 		set_state (FINISHED_ERROR);
 		LOG_ERROR_NC (N_("Transcode job failed or cancelled"));
-		_transcoder.reset ();
+		set_transcoder (shared_ptr<Transcoder> ());
 		throw;
 	}
 }
 
+shared_ptr<Transcoder>
+TranscodeJob::transcoder () const
+{
+	boost::mutex::scoped_lock lm (_transcoder_mutex);
+	return _transcoder;
+}
+
+void
+TranscodeJob::set_transcoder (shared_ptr<Transcoder> t)
+{
+	/* Keep the old transcoder until we have released the lock, so that
+	   it is not destroyed while we hold it.
+	*/
+	shared_ptr<Transcoder> old;
+
+	{
+		boost::mutex::scoped_lock lm (_transcoder_mutex);
+		old = _transcoder;
+		_transcoder = t;
+	}
+}
+
 string
 TranscodeJob::status () const
 {
-	if (!_transcoder) {
+	shared_ptr<Transcoder> t = transcoder ();
+	if (!t) {
 		return Job::status ();
 	}
 
-	float const fps = _transcoder->current_encoding_rate ();
+	float const fps = t->current_encoding_rate ();
 	if (fps == 0) {
 		return Job::status ();
 	}
@@ -99,18 +123,28 @@ TranscodeJob::status () const
 
 	s << Job::status ();
 
-	if (!finished () && !_transcoder->finishing ()) {
+	if (!finished () && !t->finishing ()) {
 		s << "; " << fixed << setprecision (1) << fps << " " << _("frames per second");
 	}
 
 	return s.str ();
 }
 
+JobResource
+TranscodeJob::resource () const
+{
+	shared_ptr<Transcoder> t = transcoder ();
+
+	/* Once we have finished encoding we are just writing the DCP out, and the next
+	   job can make a start on its encoding.
+	*/
+	return (t && t->finishing ()) ? JOB_RESOURCE_DISK : JOB_RESOURCE_CPU;
+}
+
 int
 TranscodeJob::remaining_time () const
 {
-	/* _transcoder might be destroyed by the job-runner thread */
-	shared_ptr<Transcoder> t = _transcoder;
+	shared_ptr<Transcoder> t = transcoder ();
 
 	if (!t) {
 		return 0;
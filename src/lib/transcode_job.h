@@ -22,6 +22,7 @@
  */
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include "job.h"
 
 class Transcoder;
@@ -38,9 +39,16 @@ public:
 	std::string json_name () const;
 	void run ();
 	std::string status () const;
+	JobResource resource () const;
 
 private:
 	int remaining_time () const;
+	boost::shared_ptr<Transcoder> transcoder () const;
+	void set_transcoder (boost::shared_ptr<Transcoder> t);
 
+	/** mutex for _transcoder, which is set and reset by the job's thread
+	 *  but read by others (e.g. the job manager and the GUI).
+	 */
+	mutable boost::mutex _transcoder_mutex;
 	boost::shared_ptr<Transcoder> _transcoder;
 };
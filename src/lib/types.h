@@ -93,6 +93,29 @@ enum Eyes
 	EYES_COUNT
 };
 
+/** The thing that a Job mostly uses, so that the JobManager can decide which jobs can run at the same time */
+enum JobResource
+{
+	/** the CPU (or encoding servers) */
+	JOB_RESOURCE_CPU,
+	/** the disk */
+	JOB_RESOURCE_DISK,
+	/** the network */
+	JOB_RESOURCE_NETWORK,
+	JOB_RESOURCE_COUNT
+};
+
+/** How a DCP should be split into reels */
+enum ReelType
+{
+	/** one reel for the whole DCP */
+	REELTYPE_SINGLE,
+	/** a new reel at the start of each piece of video content */
+	REELTYPE_BY_VIDEO_CONTENT,
+	/** reels of (roughly) a given size */
+	REELTYPE_BY_LENGTH
+};
+
 enum Part
 {
 	PART_LEFT_HALF,
@@ -1034,50 +1034,6 @@ divide_with_round (int64_t a, int64_t b)
 	}
 }
 
-long
-frame_info_position (int frame, Eyes eyes)
-{
-	static int const info_size = 48;
-
-	switch (eyes) {
-	case EYES_BOTH:
-		return frame * info_size;
-	case EYES_LEFT:
-		return frame * info_size * 2;
-	case EYES_RIGHT:
-		return frame * info_size * 2 + info_size;
-	default:
-		DCPOMATIC_ASSERT (false);
-	}
-
-	DCPOMATIC_ASSERT (false);
-}
-
-libdcp::FrameInfo
-read_frame_info (FILE* file, int frame, Eyes eyes)
-{
-	libdcp::FrameInfo info;
-	dcpomatic_fseek (file, frame_info_position (frame, eyes), SEEK_SET);
-	fread (&info.offset, sizeof (info.offset), 1, file);
-	fread (&info.size, sizeof (info.size), 1, file);
-
-	char hash_buffer[33];
-	fread (hash_buffer, 1, 32, file);
-	hash_buffer[32] = '\0';
-	info.hash = hash_buffer;
-
-	return info;
-}
-
-void
-write_frame_info (FILE* file, int frame, Eyes eyes, libdcp::FrameInfo info)
-{
-	dcpomatic_fseek (file, frame_info_position (frame, eyes), SEEK_SET);
-	fwrite (&info.offset, sizeof (info.offset), 1, file);
-	fwrite (&info.size, sizeof (info.size), 1, file);
-	fwrite (info.hash.c_str(), 1, info.hash.size(), file);
-}
-
 string
 video_mxf_filename (shared_ptr<libdcp::Asset> asset)
 {
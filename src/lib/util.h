@@ -90,8 +90,6 @@ extern std::string get_optional_string (std::multimap<std::string, std::string>
 extern void* wrapped_av_malloc (size_t);
 extern int64_t divide_with_round (int64_t a, int64_t b);
 extern void set_backtrace_file (boost::filesystem::path);
-extern libdcp::FrameInfo read_frame_info (FILE* file, int frame, Eyes eyes);
-extern void write_frame_info (FILE* file, int frame, Eyes eyes, libdcp::FrameInfo info);
 extern std::string video_mxf_filename (boost::shared_ptr<libdcp::Asset> asset);
 extern std::string audio_mxf_filename (boost::shared_ptr<libdcp::Asset> asset);
 
@@ -19,6 +19,10 @@
 
 #include <fstream>
 #include <cerrno>
+#include <sys/time.h>
+#ifdef DCPOMATIC_LINUX
+#include <fcntl.h>
+#endif
 #include <libdcp/mono_picture_asset.h>
 #include <libdcp/stereo_picture_asset.h>
 #include <libdcp/sound_asset.h>
@@ -34,11 +38,15 @@
 #include "dcp_content_type.h"
 #include "player.h"
 #include "audio_mapping.h"
+#include "audio_buffers.h"
 #include "config.h"
 #include "job.h"
 #include "cross.h"
 #include "md5_digester.h"
 #include "version.h"
+#include "spill_log.h"
+#include "frame_info_index.h"
+#include "memory_budget.h"
 
 #include "i18n.h"
 
@@ -55,28 +63,43 @@
 #undef set_key
 
 using std::make_pair;
+using std::list;
+using std::min;
+using std::max;
 using std::pair;
 using std::string;
-using std::list;
+using std::map;
+using std::set;
+using std::vector;
 using std::cout;
 using boost::shared_ptr;
 using boost::weak_ptr;
+using boost::optional;
 
 /** @param encoder_threads Total number of threads (local and remote) that the encoder is using */
-Writer::Writer (shared_ptr<const Film> f, weak_ptr<Job> j)
+Writer::Writer (shared_ptr<const Film> f, weak_ptr<Job> j, shared_ptr<MemoryBudget> m)
 	: _film (f)
 	, _job (j)
+	, _memory (m)
 	, _first_nonexistant_frame (0)
 	, _thread (0)
 	, _finish (false)
+	, _audio_thread (0)
+	, _audio_queued_frames (0)
+	, _audio_finish (false)
+	, _audio_reel (0)
+	, _audio_frames_written (0)
 	, _queued_full_in_memory (0)
 	, _last_written_frame (-1)
 	, _last_written_eyes (EYES_RIGHT)
-	, _maximum_frames_in_memory (0)
+	, _minimum_frames_in_memory (0)
 	, _full_written (0)
 	, _fake_written (0)
 	, _repeat_written (0)
 	, _pushed_to_disk (0)
+	, _picture_writing (0)
+	, _waits_for_space (0)
+	, _waiting_for_space (0)
 {
 	/* Remove any old DCP */
 	boost::filesystem::remove_all (_film->dir (_film->dcp_name ()));
@@ -84,46 +107,65 @@ Writer::Writer (shared_ptr<const Film> f, weak_ptr<Job> j)
 	shared_ptr<Job> job = _job.lock ();
 	DCPOMATIC_ASSERT (job);
 
-	/* Create our picture asset in a subdirectory, named according to those
-	   film's parameters which affect the video output.  We will hard-link
-	   it into the DCP later.
-	*/
+	list<pair<int, int> > const reels = _film->reels ();
+	for (list<pair<int, int> >::const_iterator i = reels.begin(); i != reels.end(); ++i) {
+		WriterReel reel (i->first, i->second);
 
-	if (_film->three_d ()) {
-		_picture_asset.reset (new libdcp::StereoPictureAsset (_film->internal_video_mxf_dir (), _film->internal_video_mxf_filename ()));
-	} else {
-		_picture_asset.reset (new libdcp::MonoPictureAsset (_film->internal_video_mxf_dir (), _film->internal_video_mxf_filename ()));
-	}
+		/* Create our picture asset in a subdirectory, named according to those
+		   film's parameters which affect the video output.  We will hard-link
+		   it into the DCP later.
+		*/
 
-	job->sub (_("Checking existing image data"));
-	check_existing_picture_mxf ();
+		if (_film->three_d ()) {
+			reel.picture_asset.reset (new libdcp::StereoPictureAsset (_film->internal_video_mxf_dir (), _film->internal_video_mxf_filename (*i)));
+		} else {
+			reel.picture_asset.reset (new libdcp::MonoPictureAsset (_film->internal_video_mxf_dir (), _film->internal_video_mxf_filename (*i)));
+		}
+
+		reel.picture_asset->set_edit_rate (_film->video_frame_rate ());
+		reel.picture_asset->set_size (_film->frame_size ());
+		reel.picture_asset->set_interop (_film->interop ());
+
+		if (_film->encrypted ()) {
+			reel.picture_asset->set_key (_film->key ());
+		}
 
-	_picture_asset->set_edit_rate (_film->video_frame_rate ());
-	_picture_asset->set_size (_film->frame_size ());
-	_picture_asset->set_interop (_film->interop ());
+		if (_film->audio_channels ()) {
+			/* Write the sound asset into the film directory so that we leave the creation
+			   of the DCP directory until the last minute.
+			*/
+			reel.sound_asset.reset (new libdcp::SoundAsset (_film->directory (), ""));
+			reel.sound_asset->set_file_name (audio_mxf_filename (reel.sound_asset));
+			reel.sound_asset->set_edit_rate (_film->video_frame_rate ());
+			reel.sound_asset->set_channels (_film->audio_channels ());
+			reel.sound_asset->set_sampling_rate (_film->audio_frame_rate ());
+			reel.sound_asset->set_interop (_film->interop ());
+
+			if (_film->encrypted ()) {
+				reel.sound_asset->set_key (_film->key ());
+			}
+		} else {
+			reel.sound_done = true;
+		}
 
-	if (_film->encrypted ()) {
-		_picture_asset->set_key (_film->key ());
+		_reels.push_back (reel);
 	}
 
-	_picture_asset_writer = _picture_asset->start_write (_first_nonexistant_frame > 0);
+	/* Frames which we have to push to disk go into segments of this many bytes */
+	_spill.reset (new SpillLog (_film->j2c_dir (), 256 * 1024 * 1024));
 
-	if (_film->audio_channels ()) {
-		_sound_asset.reset (new libdcp::SoundAsset (_film->directory (), ""));
-		_sound_asset->set_file_name (audio_mxf_filename (_sound_asset));
-		_sound_asset->set_edit_rate (_film->video_frame_rate ());
-		_sound_asset->set_channels (_film->audio_channels ());
-		_sound_asset->set_sampling_rate (_film->audio_frame_rate ());
-		_sound_asset->set_interop (_film->interop ());
+	int info_frames = _film->time_to_video_frames (_film->length ());
+	if (_film->three_d ()) {
+		info_frames *= 2;
+	}
+	/* The info file is only needed to resume an interrupted encode, so it need not hit the disk very often */
+	_frame_info.reset (new FrameInfoIndex (_film->info_file (), info_frames, 256));
 
-		if (_film->encrypted ()) {
-			_sound_asset->set_key (_film->key ());
-		}
+	job->sub (_("Checking existing image data"));
+	check_existing_picture_mxf ();
 
-		/* Write the sound asset into the film directory so that we leave the creation
-		   of the DCP directory until the last minute.
-		*/
-		_sound_asset_writer = _sound_asset->start_write ();
+	if (_film->audio_channels ()) {
+		_audio_thread = new boost::thread (boost::bind (&Writer::audio_thread, this));
 	}
 
 	set_encoder_threads (Config::instance()->num_local_encoding_threads ());
@@ -136,6 +178,10 @@ Writer::Writer (shared_ptr<const Film> f, weak_ptr<Job> j)
 Writer::~Writer ()
 {
 	terminate_thread (false);
+
+	for (vector<WriterReel>::iterator i = _reels.begin(); i != _reels.end(); ++i) {
+		delete i->finisher;
+	}
 }
 
 void
@@ -143,10 +189,7 @@ Writer::write (shared_ptr<const EncodedData> encoded, int frame, Eyes eyes)
 {
 	boost::mutex::scoped_lock lock (_mutex);
 
-	while (_queued_full_in_memory > _maximum_frames_in_memory) {
-		/* The queue is too big; wait until that is sorted out */
-		_full_condition.wait (lock);
-	}
+	wait_for_space (lock);
 
 	QueueItem qi;
 	qi.type = QueueItem::FULL;
@@ -156,15 +199,12 @@ Writer::write (shared_ptr<const EncodedData> encoded, int frame, Eyes eyes)
 	if (_film->three_d() && eyes == EYES_BOTH) {
 		/* 2D material in a 3D DCP; fake the 3D */
 		qi.eyes = EYES_LEFT;
-		_queue.push_back (qi);
-		++_queued_full_in_memory;
+		add_to_queue (qi);
 		qi.eyes = EYES_RIGHT;
-		_queue.push_back (qi);
-		++_queued_full_in_memory;
+		add_to_queue (qi);
 	} else {
 		qi.eyes = eyes;
-		_queue.push_back (qi);
-		++_queued_full_in_memory;
+		add_to_queue (qi);
 	}
 
 	/* Now there's something to do: wake anything wait()ing on _empty_condition */
@@ -176,30 +216,25 @@ Writer::fake_write (int frame, Eyes eyes)
 {
 	boost::mutex::scoped_lock lock (_mutex);
 
-	while (_queued_full_in_memory > _maximum_frames_in_memory) {
-		/* The queue is too big; wait until that is sorted out */
-		_full_condition.wait (lock);
-	}
+	wait_for_space (lock);
 
-	FILE* file = fopen_boost (_film->info_file (), "rb");
-	if (!file) {
+	optional<libdcp::FrameInfo> info = _frame_info->read (frame, eyes);
+	if (!info) {
 		throw ReadFileError (_film->info_file ());
 	}
-	libdcp::FrameInfo info = read_frame_info (file, frame, eyes);
-	fclose (file);
 
 	QueueItem qi;
 	qi.type = QueueItem::FAKE;
-	qi.size = info.size;
+	qi.size = info->size;
 	qi.frame = frame;
 	if (_film->three_d() && eyes == EYES_BOTH) {
 		qi.eyes = EYES_LEFT;
-		_queue.push_back (qi);
+		add_to_queue (qi);
 		qi.eyes = EYES_RIGHT;
-		_queue.push_back (qi);
+		add_to_queue (qi);
 	} else {
 		qi.eyes = eyes;
-		_queue.push_back (qi);
+		add_to_queue (qi);
 	}
 
 	/* Now there's something to do: wake anything wait()ing on _empty_condition */
@@ -210,35 +245,219 @@ Writer::fake_write (int frame, Eyes eyes)
 void
 Writer::write (shared_ptr<const AudioBuffers> audio)
 {
-	if (_sound_asset) {
-		_sound_asset_writer->write (audio->data(), audio->frames());
+	if (!_audio_thread) {
+		return;
+	}
+
+	boost::mutex::scoped_lock lm (_audio_mutex);
+
+	/* Don't let the audio thread get too far behind */
+	while (_audio_queued_frames > _film->audio_frame_rate () * 2 && !_audio_finish) {
+		_audio_condition.wait (lm);
+	}
+
+	if (_audio_finish) {
+		/* The audio thread has failed; the error will be passed on by rethrow() */
+		return;
+	}
+
+	_audio_queue.push_back (audio);
+	_audio_queued_frames += audio->frames ();
+	_audio_condition.notify_all ();
+}
+
+/** Thread to write audio to our reels' sound assets.  Whatever has been queued since
+ *  we last looked is written in one go, since the conversion and I/O in the
+ *  sound asset writer are much more efficient with large blocks.
+ */
+void
+Writer::audio_thread ()
+try
+{
+	AudioBuffers batch (_film->audio_channels (), _film->audio_frame_rate ());
+
+	while (true) {
+		boost::mutex::scoped_lock lm (_audio_mutex);
+		while (_audio_queue.empty () && !_audio_finish) {
+			_audio_condition.wait (lm);
+		}
+
+		if (_audio_queue.empty ()) {
+			/* We've been asked to finish and there is nothing left to write */
+			break;
+		}
+
+		list<shared_ptr<const AudioBuffers> > pending;
+		pending.swap (_audio_queue);
+		int const frames = _audio_queued_frames;
+		_audio_queued_frames = 0;
+		_audio_condition.notify_all ();
+		lm.unlock ();
+
+		if (pending.size() == 1) {
+			write_audio (pending.front().get(), pending.front()->frames());
+			continue;
+		}
+
+		batch.ensure_size (frames);
+		batch.set_frames (frames);
+		int offset = 0;
+		for (list<shared_ptr<const AudioBuffers> >::const_iterator i = pending.begin(); i != pending.end(); ++i) {
+			batch.copy_from (i->get(), (*i)->frames(), 0, offset);
+			offset += (*i)->frames ();
+		}
+
+		write_audio (&batch, frames);
+	}
+}
+catch (...)
+{
+	store_current ();
+
+	/* Stop anybody waiting to give us more audio */
+	boost::mutex::scoped_lock lm (_audio_mutex);
+	_audio_finish = true;
+	_audio_condition.notify_all ();
+}
+
+/** Write the first `frames' frames of some audio to our reels' sound assets, moving
+ *  on to the next reel whenever we reach the end of one.  Called from audio_thread().
+ */
+void
+Writer::write_audio (AudioBuffers const * audio, int frames)
+{
+	vector<float const *> data (audio->channels ());
+	int const last_reel = _reels.size() - 1;
+
+	int offset = 0;
+	while (offset < frames) {
+		WriterReel& reel = _reels[_audio_reel];
+
+		if (!reel.sound_asset_writer) {
+			reel.sound_asset_writer = reel.sound_asset->start_write ();
+		}
+
+		/* The last reel takes whatever is left over */
+		int this_time = frames - offset;
+		int64_t reel_end = 0;
+		if (_audio_reel < last_reel) {
+			reel_end = int64_t (reel.to) * _film->audio_frame_rate () / _film->video_frame_rate ();
+			this_time = min (int64_t (this_time), reel_end - _audio_frames_written);
+		}
+
+		if (this_time > 0) {
+			for (int i = 0; i < audio->channels(); ++i) {
+				data[i] = audio->data(i) + offset;
+			}
+			reel.sound_asset_writer->write (&data[0], this_time);
+			offset += this_time;
+			_audio_frames_written += this_time;
+		}
+
+		if (_audio_reel < last_reel && _audio_frames_written >= reel_end) {
+			/* That's all the sound for this reel */
+			boost::mutex::scoped_lock lm (_reels_mutex);
+			reel.sound_done = true;
+			lm.unlock ();
+
+			maybe_finish_reel (_audio_reel);
+			++_audio_reel;
+		}
+	}
+}
+
+/** Wait until there is room in the queue for more frames, keeping track of how long
+ *  our callers spend doing this.
+ *  @param lock Lock on _mutex.
+ */
+void
+Writer::wait_for_space (boost::mutex::scoped_lock& lock)
+{
+	if (!over_memory_budget ()) {
+		return;
+	}
+
+	struct timeval start;
+	gettimeofday (&start, 0);
+
+	/* Our thread may need to push some frames to disk to sort this out, so make sure it's awake */
+	_empty_condition.notify_all ();
+
+	while (over_memory_budget ()) {
+		/* The queue is too big; wait until that is sorted out */
+		_full_condition.wait (lock);
+	}
+
+	struct timeval end;
+	gettimeofday (&end, 0);
+
+	++_waits_for_space;
+	_waiting_for_space += seconds (end) - seconds (start);
+}
+
+/** Add an item to _queue.  This must be called with a lock on _mutex held */
+void
+Writer::add_to_queue (QueueItem const & qi)
+{
+	bool const inserted = _queue.insert (make_pair (qi.key (), qi)).second;
+	/* We should never be given the same frame twice */
+	DCPOMATIC_ASSERT (inserted);
+
+	if (qi.type == QueueItem::FULL && qi.encoded) {
+		_full_in_memory.insert (qi.key ());
+		++_queued_full_in_memory;
+		charge (qi.encoded);
+	}
+}
+
+/** Note that a queue item is holding some data in memory.  Data which is shared by
+ *  several items (as when 2D frames are written to both eyes of a 3D DCP) is only
+ *  charged to _memory once.  _mutex must be held.
+ */
+void
+Writer::charge (shared_ptr<const EncodedData> data)
+{
+	if (++_charges[data.get()] == 1) {
+		_memory->add (MemoryBudget::WRITER_QUEUE, data->size ());
+	}
+}
+
+/** Note that a queue item is no longer holding some data in memory.  _mutex must be held. */
+void
+Writer::discharge (shared_ptr<const EncodedData> data)
+{
+	map<EncodedData const *, int>::iterator i = _charges.find (data.get ());
+	DCPOMATIC_ASSERT (i != _charges.end ());
+	if (--i->second == 0) {
+		_charges.erase (i);
+		_memory->remove (MemoryBudget::WRITER_QUEUE, data->size ());
 	}
 }
 
 /** This must be called from Writer::thread() with an appropriate lock held */
 bool
-Writer::have_sequenced_image_at_queue_head ()
+Writer::have_sequenced_image_at_queue_head () const
 {
 	if (_queue.empty ()) {
 		return false;
 	}
 
-	_queue.sort ();
-
 	/* The queue should contain only EYES_LEFT/EYES_RIGHT pairs or EYES_BOTH */
 
-	if (_queue.front().eyes == EYES_BOTH) {
+	QueueItem const & head = _queue.begin()->second;
+
+	if (head.eyes == EYES_BOTH) {
 		/* 2D */
-		return _queue.front().frame == (_last_written_frame + 1);
+		return head.frame == (_last_written_frame + 1);
 	}
 
 	/* 3D */
 
-	if (_last_written_eyes == EYES_LEFT && _queue.front().frame == _last_written_frame && _queue.front().eyes == EYES_RIGHT) {
+	if (_last_written_eyes == EYES_LEFT && head.frame == _last_written_frame && head.eyes == EYES_RIGHT) {
 		return true;
 	}
 
-	if (_last_written_eyes == EYES_RIGHT && _queue.front().frame == (_last_written_frame + 1) && _queue.front().eyes == EYES_LEFT) {
+	if (_last_written_eyes == EYES_RIGHT && head.frame == (_last_written_frame + 1) && head.eyes == EYES_LEFT) {
 		return true;
 	}
 
@@ -258,7 +477,7 @@ try
 
 		while (true) {
 
-			if (_finish || _queued_full_in_memory > _maximum_frames_in_memory || have_sequenced_image_at_queue_head ()) {
+			if (_finish || over_memory_budget () || have_sequenced_image_at_queue_head ()) {
 				/* We've got something to do: go and do it */
 				break;
 			}
@@ -279,8 +498,8 @@ try
 			/* (Hopefully temporarily) log anything that was not written */
 			if (!_queue.empty() && !have_sequenced_image_at_queue_head()) {
 				LOG_WARNING (N_("Finishing writer with a left-over queue of %1:"), _queue.size());
-				for (list<QueueItem>::const_iterator i = _queue.begin(); i != _queue.end(); ++i) {
-					LOG_WARNING (N_("- type %1, size %2, frame %3, eyes %4"), i->type, i->size, i->frame, i->eyes);
+				for (map<QueueKey, QueueItem>::const_iterator i = _queue.begin(); i != _queue.end(); ++i) {
+					LOG_WARNING (N_("- type %1, size %2, frame %3, eyes %4"), i->second.type, i->second.size, i->second.frame, i->second.eyes);
 				}
 				LOG_WARNING (N_("Last written frame %1, last written eyes %2"), _last_written_frame, _last_written_eyes);
 			}
@@ -290,46 +509,87 @@ try
 		/* Write any frames that we can write; i.e. those that are in sequence. */
 		while (have_sequenced_image_at_queue_head ()) {
 			done_something = true;
-			QueueItem qi = _queue.front ();
-			_queue.pop_front ();
+			QueueItem qi = _queue.begin()->second;
+			_queue.erase (_queue.begin ());
 			if (qi.type == QueueItem::FULL && qi.encoded) {
 				--_queued_full_in_memory;
+				_full_in_memory.erase (qi.key ());
+				discharge (qi.encoded);
 			}
 
 			lock.unlock ();
+
+			int const reel_number = reel_index (qi.frame);
+			WriterReel& reel = _reels[reel_number];
+			if (!reel.picture_asset_writer) {
+				reel.picture_asset_writer = reel.picture_asset->start_write (_first_nonexistant_frame > reel.from);
+
+#if defined(DCPOMATIC_LINUX) || defined(DCPOMATIC_OSX)
+				/* Reserve space for the whole MXF so that the filesystem can lay it out in big pieces;
+				   anything that we don't use is given back when the reel is finished.
+				*/
+				uint64_t size = uint64_t (_film->j2k_bandwidth() / 8) * (reel.to - reel.from) / _film->video_frame_rate ();
+				if (_film->three_d ()) {
+					/* Each frame has two eyes */
+					size *= 2;
+				}
+				if (!preallocate_file (reel.picture_asset->path (), size)) {
+					LOG_GENERAL ("Could not preallocate space for %1", reel.picture_asset->path().string());
+				}
+#endif
+			}
+
 			switch (qi.type) {
 			case QueueItem::FULL:
 			{
 				LOG_DEBUG (N_("Writer FULL-writes %1 to MXF"), qi.frame);
 				if (!qi.encoded) {
-					qi.encoded.reset (new EncodedData (_film->j2c_path (qi.frame, qi.eyes, false)));
+					qi.encoded = _spill->read (qi.frame, qi.eyes);
 				}
 
-				libdcp::FrameInfo fin = _picture_asset_writer->write (qi.encoded->data(), qi.encoded->size());
-				qi.encoded->write_info (_film, qi.frame, qi.eyes, fin);
+				struct timeval start;
+				gettimeofday (&start, 0);
+				libdcp::FrameInfo fin = reel.picture_asset_writer->write (qi.encoded->data(), qi.encoded->size());
+				add_picture_write_time (start);
+				_frame_info->write (qi.frame, qi.eyes, fin);
 				_last_written[qi.eyes] = qi.encoded;
 				++_full_written;
 				break;
 			}
 			case QueueItem::FAKE:
 				LOG_DEBUG (N_("Writer FAKE-writes %1 to MXF"), qi.frame);
-				_picture_asset_writer->fake_write (qi.size);
+				reel.picture_asset_writer->fake_write (qi.size);
 				_last_written[qi.eyes].reset ();
 				++_fake_written;
 				break;
 			case QueueItem::REPEAT:
 			{
 				LOG_DEBUG (N_("Writer REPEAT-writes %1 to MXF"), qi.frame);
-				libdcp::FrameInfo fin = _picture_asset_writer->write (
+				struct timeval start;
+				gettimeofday (&start, 0);
+				libdcp::FrameInfo fin = reel.picture_asset_writer->write (
 					_last_written[qi.eyes]->data(),
 					_last_written[qi.eyes]->size()
 					);
+				add_picture_write_time (start);
 
-				_last_written[qi.eyes]->write_info (_film, qi.frame, qi.eyes, fin);
+				_frame_info->write (qi.frame, qi.eyes, fin);
 				++_repeat_written;
 				break;
 			}
 			}
+
+			if (qi.frame == (reel.to - 1) && qi.eyes != EYES_LEFT && reel_number < int (_reels.size()) - 1) {
+				/* That's all the picture for this reel; the last reel is finished by finish()
+				   as we don't know for sure where it will end.
+				*/
+				boost::mutex::scoped_lock lm (_reels_mutex);
+				reel.picture_done = true;
+				lm.unlock ();
+
+				maybe_finish_reel (reel_number);
+			}
+
 			lock.lock ();
 
 			_last_written_frame = qi.frame;
@@ -349,27 +609,27 @@ try
 			}
 		}
 
-		while (_queued_full_in_memory > _maximum_frames_in_memory) {
+		while (over_memory_budget ()) {
 			done_something = true;
 			/* Too many frames in memory which can't yet be written to the stream.
 			   Write some FULL frames to disk.
 			*/
 
-			/* Find one from the back of the queue */
-			_queue.sort ();
-			list<QueueItem>::reverse_iterator i = _queue.rbegin ();
-			while (i != _queue.rend() && (i->type != QueueItem::FULL || !i->encoded)) {
-				++i;
-			}
+			/* Take the one furthest from being written */
+			DCPOMATIC_ASSERT (!_full_in_memory.empty ());
+			set<QueueKey>::iterator last = _full_in_memory.end ();
+			--last;
+			map<QueueKey, QueueItem>::iterator i = _queue.find (*last);
+			_full_in_memory.erase (last);
 
-			DCPOMATIC_ASSERT (i != _queue.rend());
+			DCPOMATIC_ASSERT (i != _queue.end());
 
 			/* We will definitely write this data to disk, so clear it before we release the lock */
-			shared_ptr<const EncodedData> to_write = i->encoded;
-			i->encoded.reset ();
+			shared_ptr<const EncodedData> to_write = i->second.encoded;
+			i->second.encoded.reset ();
 
 			/* Take a copy of the frame number and eyes so that we can unlock while we write */
-			QueueItem qi = *i;
+			QueueItem qi = i->second;
 
 			++_pushed_to_disk;
 			lock.unlock ();
@@ -381,10 +641,11 @@ try
 				_last_written_eyes, qi.frame
 				);
 
-			to_write->write (_film, qi.frame, qi.eyes);
+			_spill->write (to_write, qi.frame, qi.eyes);
 
 			lock.lock ();
 			--_queued_full_in_memory;
+			discharge (to_write);
 		}
 
 		if (!done_something) {
@@ -404,6 +665,19 @@ catch (...)
 	store_current ();
 }
 
+/** Note that a write to the picture MXF which began at `start' has just finished;
+ *  called from our thread without _mutex held.
+ */
+void
+Writer::add_picture_write_time (struct timeval start)
+{
+	struct timeval end;
+	gettimeofday (&end, 0);
+
+	boost::mutex::scoped_lock lm (_mutex);
+	_picture_writing += seconds (end) - seconds (start);
+}
+
 void
 Writer::terminate_thread (bool can_throw)
 {
@@ -418,6 +692,29 @@ Writer::terminate_thread (bool can_throw)
 	lock.unlock ();
 
  	_thread->join ();
+
+	if (_audio_thread) {
+		boost::mutex::scoped_lock lm (_audio_mutex);
+		if (!can_throw) {
+			/* We are giving up, so there's no point in writing any more */
+			_audio_queue.clear ();
+		}
+		_audio_finish = true;
+		_audio_condition.notify_all ();
+		lm.unlock ();
+
+		_audio_thread->join ();
+		delete _audio_thread;
+		_audio_thread = 0;
+	}
+
+	/* Nothing else will start finishing a reel now, so we can wait for those that are going */
+	for (vector<WriterReel>::iterator i = _reels.begin(); i != _reels.end(); ++i) {
+		if (i->finisher) {
+			i->finisher->join ();
+		}
+	}
+
 	if (can_throw) {
 		rethrow ();
 	}
@@ -437,64 +734,33 @@ Writer::finish ()
 
 	terminate_thread (true);
 
-	LOG_DEBUG_NC (N_("Finalizing writers"));
-
-	_picture_asset_writer->finalize ();
-	if (_sound_asset_writer) {
-		_sound_asset_writer->finalize ();
-	}
-
-	int const frames = _last_written_frame + 1;
-
-	_picture_asset->set_duration (frames);
-
-	/* Hard-link the video MXF into the DCP */
-	LOG_GENERAL_NC (N_("Hard-linking video MXF into DCP"));
-
-	boost::filesystem::path video_from = _picture_asset->path ();
-
-	boost::filesystem::path video_to;
-	video_to /= _film->dir (_film->dcp_name());
-	video_to /= video_mxf_filename (_picture_asset);
+	shared_ptr<Job> job = _job.lock ();
+	DCPOMATIC_ASSERT (job);
 
-	boost::system::error_code ec;
-	boost::filesystem::create_hard_link (video_from, video_to, ec);
-	if (ec) {
-		LOG_WARNING ("Hard-link failed; copying instead (%1)", ec.message ());
-		boost::filesystem::copy_file (video_from, video_to, ec);
-		if (ec) {
-			LOG_ERROR ("Failed to copy video file from %1 to %2 (%3)", video_from.string(), video_to.string(), ec.message ());
-			throw FileError (ec.message(), video_from);
+	/* Finish any reels which were not finished in the background while we were encoding;
+	   usually this is just the last one.
+	*/
+	for (size_t i = 0; i < _reels.size(); ++i) {
+		WriterReel const & reel = _reels[i];
+		if (reel.finisher || !reel.picture_asset_writer) {
+			continue;
 		}
-	}
-
-	/* And update the asset */
 
-	_picture_asset->set_directory (_film->dir (_film->dcp_name ()));
-	_picture_asset->set_file_name (video_mxf_filename (_picture_asset));
+		LOG_DEBUG (N_("Finishing reel %1"), i);
+		finish_reel (i, min (reel.to, _last_written_frame + 1) - reel.from, job);
+	}
 
-	/* Move the audio MXF into the DCP */
-	LOG_GENERAL_NC (N_("Moving audio MXF into DCP"));
+	rethrow ();
 
-	if (_sound_asset) {
-		boost::filesystem::path audio_to;
-		audio_to /= _film->dir (_film->dcp_name ());
-		audio_to /= audio_mxf_filename (_sound_asset);
+	libdcp::DCP dcp (_film->dir (_film->dcp_name()));
 
-		boost::filesystem::rename (_film->file (audio_mxf_filename (_sound_asset)), audio_to, ec);
-		if (ec) {
-			throw FileError (
-				String::compose (_("could not move audio MXF into the DCP (%1)"), ec.value ()),
-				_film->file (audio_mxf_filename (_sound_asset))
-				);
+	int frames = 0;
+	for (vector<WriterReel>::const_iterator i = _reels.begin(); i != _reels.end(); ++i) {
+		if (i->picture_asset_writer) {
+			frames += i->picture_asset->duration ();
 		}
-
-		_sound_asset->set_directory (_film->dir (_film->dcp_name ()));
-		_sound_asset->set_duration (frames);
 	}
 
-	libdcp::DCP dcp (_film->dir (_film->dcp_name()));
-
 	shared_ptr<libdcp::CPL> cpl (
 		new libdcp::CPL (
 			_film->dir (_film->dcp_name()),
@@ -507,22 +773,66 @@ Writer::finish ()
 
 	dcp.add_cpl (cpl);
 
-	cpl->add_reel (shared_ptr<libdcp::Reel> (new libdcp::Reel (
-							 _picture_asset,
-							 _sound_asset,
-							 shared_ptr<libdcp::SubtitleAsset> ()
-							 )
-			       ));
+	for (vector<WriterReel>::iterator i = _reels.begin(); i != _reels.end(); ++i) {
+		if (!i->picture_asset_writer) {
+			/* We never got as far as this reel */
+			continue;
+		}
 
-	shared_ptr<Job> job = _job.lock ();
-	DCPOMATIC_ASSERT (job);
+		/* Hard-link the video MXF into the DCP */
+		LOG_GENERAL_NC (N_("Hard-linking video MXF into DCP"));
 
-	job->sub (_("Computing image digest"));
-	_picture_asset->compute_digest (boost::bind (&Job::set_progress, job.get(), _1, false));
+		boost::filesystem::path video_from = i->picture_asset->path ();
 
-	if (_sound_asset) {
-		job->sub (_("Computing audio digest"));
-		_sound_asset->compute_digest (boost::bind (&Job::set_progress, job.get(), _1, false));
+		boost::filesystem::path video_to;
+		video_to /= _film->dir (_film->dcp_name());
+		video_to /= video_mxf_filename (i->picture_asset);
+
+		boost::system::error_code ec;
+		boost::filesystem::create_hard_link (video_from, video_to, ec);
+		if (ec) {
+			LOG_WARNING ("Hard-link failed; copying instead (%1)", ec.message ());
+			job->sub (_("Copying image data into DCP"));
+			try {
+				dcpomatic_copy_file (video_from, video_to, boost::bind (&Job::set_progress, job.get(), _1, false));
+			} catch (FileError& e) {
+				LOG_ERROR ("Failed to copy video file from %1 to %2 (%3)", video_from.string(), video_to.string(), e.what ());
+				throw;
+			}
+		}
+
+		/* And update the asset */
+
+		i->picture_asset->set_directory (_film->dir (_film->dcp_name ()));
+		i->picture_asset->set_file_name (video_mxf_filename (i->picture_asset));
+
+		/* Move the audio MXF into the DCP */
+		if (i->sound_asset) {
+			LOG_GENERAL_NC (N_("Moving audio MXF into DCP"));
+
+			boost::filesystem::path audio_to;
+			audio_to /= _film->dir (_film->dcp_name ());
+			audio_to /= audio_mxf_filename (i->sound_asset);
+
+			boost::filesystem::path const audio_from = _film->file (audio_mxf_filename (i->sound_asset));
+			boost::filesystem::rename (audio_from, audio_to, ec);
+			if (ec) {
+				/* Probably the DCP is on a different filesystem; copy it across instead */
+				LOG_WARNING ("Move failed; copying instead (%1)", ec.message ());
+				job->sub (_("Copying audio data into DCP"));
+				dcpomatic_copy_file (audio_from, audio_to, boost::bind (&Job::set_progress, job.get(), _1, false));
+				boost::filesystem::remove (audio_from);
+			}
+
+			i->sound_asset->set_directory (_film->dir (_film->dcp_name ()));
+		}
+
+		cpl->add_reel (shared_ptr<libdcp::Reel> (new libdcp::Reel (
+								 i->picture_asset,
+								 i->sound_asset,
+								 shared_ptr<libdcp::SubtitleAsset> ()
+								 )
+				       ));
 	}
 
 	libdcp::XMLMetadata meta;
@@ -534,6 +844,127 @@ Writer::finish ()
 	LOG_GENERAL (
 		N_("Wrote %1 FULL, %2 FAKE, %3 REPEAT; %4 pushed to disk"), _full_written, _fake_written, _repeat_written, _pushed_to_disk
 		);
+	LOG_GENERAL (
+		N_("Spent %1s writing picture data; frame sources waited %2 times for a total of %3s for the queue to drain"),
+		_picture_writing, _waits_for_space, _waiting_for_space
+		);
+}
+
+static void
+ignore_progress (float)
+{
+
+}
+
+/** @param frame Video frame index.
+ *  @return Index into _reels of the reel which contains the frame.
+ */
+int
+Writer::reel_index (int frame) const
+{
+	/* Anything off the end (which there should not be) goes into the last reel */
+	for (size_t i = 0; i < _reels.size() - 1; ++i) {
+		if (frame < _reels[i].to) {
+			return i;
+		}
+	}
+
+	return _reels.size() - 1;
+}
+
+/** Start finishing a reel in the background if all its picture and sound have been written */
+void
+Writer::maybe_finish_reel (int index)
+{
+	boost::mutex::scoped_lock lm (_reels_mutex);
+
+	WriterReel& reel = _reels[index];
+	if (!reel.picture_done || !reel.sound_done || reel.finisher) {
+		return;
+	}
+
+	LOG_DEBUG (N_("Finishing reel %1 in the background"), index);
+	reel.finisher = new boost::thread (boost::bind (&Writer::finish_reel_in_background, this, index));
+}
+
+void
+Writer::finish_reel_in_background (int index)
+{
+	try {
+		WriterReel const & reel = _reels[index];
+		finish_reel (index, reel.to - reel.from, shared_ptr<Job> ());
+	} catch (...) {
+		store_current ();
+	}
+}
+
+/** Finalize a reel's MXFs and compute their digests.  Nothing else must be using
+ *  the reel's writers while this happens.
+ *  @param index Index into _reels.
+ *  @param duration Duration of the reel in video frames.
+ *  @param job Job to report progress to, or 0.
+ */
+void
+Writer::finish_reel (int index, int duration, shared_ptr<Job> job)
+{
+	WriterReel& reel = _reels[index];
+
+	reel.picture_asset_writer->finalize ();
+	reel.picture_asset->set_duration (duration);
+	release_preallocation (reel.picture_asset->path ());
+
+	if (reel.sound_asset) {
+		if (reel.sound_asset_writer) {
+			reel.sound_asset_writer->finalize ();
+			reel.sound_asset->set_duration (duration);
+		} else {
+			/* We never got any audio for this reel */
+			reel.sound_asset.reset ();
+		}
+	}
+
+	/* The sound MXF is hashed in the background while we hash the picture one,
+	   so that the two passes over the disk overlap.
+	*/
+	boost::thread* sound_digest = 0;
+	if (reel.sound_asset) {
+		sound_digest = new boost::thread (boost::bind (&Writer::compute_sound_digest, this, reel.sound_asset));
+	}
+
+	try {
+		if (job) {
+			job->sub (_("Computing image digest"));
+			reel.picture_asset->compute_digest (boost::bind (&Job::set_progress, job.get(), _1, false));
+		} else {
+			reel.picture_asset->compute_digest (boost::bind (&ignore_progress, _1));
+		}
+	} catch (...) {
+		if (sound_digest) {
+			sound_digest->join ();
+			delete sound_digest;
+		}
+		throw;
+	}
+
+	if (sound_digest) {
+		if (job) {
+			job->sub (_("Computing audio digest"));
+			job->set_progress_unknown ();
+		}
+		sound_digest->join ();
+		delete sound_digest;
+	}
+}
+
+/** Compute the digest of a sound asset; run in a thread by finish_reel() */
+void
+Writer::compute_sound_digest (shared_ptr<libdcp::SoundAsset> asset)
+{
+	try {
+		asset->compute_digest (boost::bind (&ignore_progress, _1));
+	} catch (...) {
+		store_current ();
+	}
 }
 
 /** Tell the writer that frame `f' should be a repeat of the frame before it */
@@ -542,22 +973,19 @@ Writer::repeat (int f, Eyes e)
 {
 	boost::mutex::scoped_lock lock (_mutex);
 
-	while (_queued_full_in_memory > _maximum_frames_in_memory) {
-		/* The queue is too big; wait until that is sorted out */
-		_full_condition.wait (lock);
-	}
+	wait_for_space (lock);
 
 	QueueItem qi;
 	qi.type = QueueItem::REPEAT;
 	qi.frame = f;
 	if (_film->three_d() && e == EYES_BOTH) {
 		qi.eyes = EYES_LEFT;
-		_queue.push_back (qi);
+		add_to_queue (qi);
 		qi.eyes = EYES_RIGHT;
-		_queue.push_back (qi);
+		add_to_queue (qi);
 	} else {
 		qi.eyes = e;
-		_queue.push_back (qi);
+		add_to_queue (qi);
 	}
 
 	/* Now there's something to do: wake anything wait()ing on _empty_condition */
@@ -568,17 +996,15 @@ bool
 Writer::check_existing_picture_mxf_frame (FILE* mxf, int f, Eyes eyes)
 {
 	/* Read the frame info as written */
-	FILE* file = fopen_boost (_film->info_file (), "rb");
-	if (!file) {
-		LOG_GENERAL ("Existing frame %1 has no info file", f);
+	optional<libdcp::FrameInfo> info = _frame_info->read (f, eyes);
+	if (!info) {
+		LOG_GENERAL ("Existing frame %1 has no info", f);
 		return false;
 	}
-	libdcp::FrameInfo info = read_frame_info (file, f, eyes);
-	fclose (file);
 
 	/* Read the data from the MXF and hash it */
-	dcpomatic_fseek (mxf, info.offset, SEEK_SET);
-	EncodedData data (info.size);
+	dcpomatic_fseek (mxf, info->offset, SEEK_SET);
+	EncodedData data (info->size);
 	size_t const read = fread (data.data(), 1, data.size(), mxf);
 	if (read != static_cast<size_t> (data.size ())) {
 		LOG_GENERAL ("Existing frame %1 is incomplete", f);
@@ -587,7 +1013,7 @@ Writer::check_existing_picture_mxf_frame (FILE* mxf, int f, Eyes eyes)
 
 	MD5Digester digester;
 	digester.add (data.data(), data.size());
-	if (digester.get() != info.hash) {
+	if (digester.get() != info->hash) {
 		LOG_GENERAL ("Existing frame %1 failed hash check", f);
 		return false;
 	}
@@ -595,41 +1021,210 @@ Writer::check_existing_picture_mxf_frame (FILE* mxf, int f, Eyes eyes)
 	return true;
 }
 
+/** State shared between the threads which check the frames of an existing MXF */
+struct ExistingFrameCheck
+{
+	ExistingFrameCheck (boost::filesystem::path m, int f, int t)
+		: mxf (m)
+		, from (f)
+		, candidates (t - f)
+		, next (f)
+		, first_failure (t)
+		, checked (0)
+		, running (0)
+	{}
+
+	/** the MXF being checked */
+	boost::filesystem::path const mxf;
+	/** first frame in the MXF */
+	int const from;
+	/** number of frames at the start of the MXF that might be OK */
+	int const candidates;
+	/** next frame for a thread to check */
+	int next;
+	/** first frame that we know is not OK */
+	int first_failure;
+	/** number of frames that have been checked */
+	int checked;
+	/** number of threads still checking */
+	int running;
+	boost::mutex mutex;
+	boost::condition condition;
+};
+
+/** @return true if our frame info says that frame `f' is completely contained
+ *  within the first `mxf_size' bytes of the MXF.
+ */
+bool
+Writer::existing_picture_mxf_frame_present (int f, int64_t mxf_size) const
+{
+	Eyes eyes[2] = { EYES_BOTH, EYES_COUNT };
+	if (_film->three_d ()) {
+		eyes[0] = EYES_LEFT;
+		eyes[1] = EYES_RIGHT;
+	}
+
+	for (int i = 0; i < 2 && eyes[i] != EYES_COUNT; ++i) {
+		optional<libdcp::FrameInfo> info = _frame_info->read (f, eyes[i]);
+		if (!info || int64_t (info->offset + info->size) > mxf_size) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** Find out how much of our DCP's picture data is already present and correct,
+ *  setting up _first_nonexistant_frame.
+ */
 void
 Writer::check_existing_picture_mxf ()
 {
-	/* Try to open the existing MXF */
-	FILE* mxf = fopen_boost (_picture_asset->path(), "rb");
-	if (!mxf) {
-		LOG_GENERAL ("Could not open existing MXF at %1 (errno=%2)", _picture_asset->path().string(), errno);
-		return;
+	/* Reels are written in order, so there's no point in looking past the first incomplete one */
+	for (vector<WriterReel>::const_iterator i = _reels.begin(); i != _reels.end(); ++i) {
+		_first_nonexistant_frame = check_existing_picture_mxf (*i);
+		if (_first_nonexistant_frame < i->to) {
+			break;
+		}
 	}
 
-	while (true) {
+	LOG_GENERAL ("Have %1 existing frames", _first_nonexistant_frame);
+}
 
-		shared_ptr<Job> job = _job.lock ();
-		DCPOMATIC_ASSERT (job);
+/** @return the first frame of a reel which does not already exist in its MXF */
+int
+Writer::check_existing_picture_mxf (WriterReel const & reel)
+{
+	boost::filesystem::path const mxf = reel.picture_asset->path ();
 
-		job->set_progress_unknown ();
+	if (!boost::filesystem::exists (mxf)) {
+		LOG_GENERAL ("No existing MXF at %1", mxf.string());
+		return reel.from;
+	}
 
-		if (_film->three_d ()) {
-			if (!check_existing_picture_mxf_frame (mxf, _first_nonexistant_frame, EYES_LEFT)) {
+	int64_t const mxf_size = boost::filesystem::file_size (mxf);
+
+	/* Frames are written to the MXF in order, so we can binary-search the frame info for the
+	   first frame which is not in the file.  This is cheap as it does not read the MXF.
+	*/
+	int lo = reel.from;
+	int hi = reel.to;
+	while (lo < hi) {
+		int const mid = lo + (hi - lo) / 2;
+		if (existing_picture_mxf_frame_present (mid, mxf_size)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo == reel.from) {
+		return lo;
+	}
+
+	/* Now hash all the frames before that point to make sure that they are really OK;
+	   the first one which is not is where we must start encoding.
+	*/
+	ExistingFrameCheck check (mxf, reel.from, lo);
+
+	shared_ptr<Job> job = _job.lock ();
+	DCPOMATIC_ASSERT (job);
+
+	/* The configuration may ask for no local encoding threads, but we always need at least one here */
+	int const threads = max (1, Config::instance()->num_local_encoding_threads ());
+
+	boost::thread_group group;
+	for (int i = 0; i < threads; ++i) {
+		boost::mutex::scoped_lock lm (check.mutex);
+		++check.running;
+		lm.unlock ();
+		group.create_thread (boost::bind (&Writer::check_existing_picture_mxf_thread, this, &check));
+	}
+
+	try {
+		while (true) {
+			boost::mutex::scoped_lock lm (check.mutex);
+			if (check.running == 0) {
 				break;
 			}
-			if (!check_existing_picture_mxf_frame (mxf, _first_nonexistant_frame, EYES_RIGHT)) {
+			check.condition.timed_wait (lm, boost::posix_time::milliseconds (250));
+			float const progress = float (check.checked) / check.candidates;
+			lm.unlock ();
+
+			job->set_progress (progress);
+		}
+	} catch (...) {
+		/* Make the checking threads stop before we go */
+		boost::mutex::scoped_lock lm (check.mutex);
+		check.first_failure = check.from;
+		lm.unlock ();
+		group.join_all ();
+		throw;
+	}
+
+	group.join_all ();
+
+	return check.first_failure;
+}
+
+void
+Writer::check_existing_picture_mxf_thread (ExistingFrameCheck* check)
+{
+	/* Number of frames to check in each contiguous piece of work */
+	int const chunk = 24;
+
+	FILE* mxf = fopen_boost (check->mxf, "rb");
+
+	if (mxf) {
+#ifdef DCPOMATIC_LINUX
+		posix_fadvise (fileno (mxf), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+		while (true) {
+			boost::mutex::scoped_lock lm (check->mutex);
+			if (check->next >= check->first_failure) {
 				break;
 			}
-		} else {
-			if (!check_existing_picture_mxf_frame (mxf, _first_nonexistant_frame, EYES_BOTH)) {
-				break;
+			int const from = check->next;
+			int const to = min (from + chunk, check->first_failure);
+			check->next = to;
+			lm.unlock ();
+
+			int f = from;
+			try {
+				for (; f < to; ++f) {
+					bool ok = false;
+					if (_film->three_d ()) {
+						ok = check_existing_picture_mxf_frame (mxf, f, EYES_LEFT) && check_existing_picture_mxf_frame (mxf, f, EYES_RIGHT);
+					} else {
+						ok = check_existing_picture_mxf_frame (mxf, f, EYES_BOTH);
+					}
+					if (!ok) {
+						break;
+					}
+				}
+			} catch (...) {
+				/* Treat anything that goes wrong as a failed frame */
+			}
+
+			lm.lock ();
+			check->checked += to - from;
+			if (f < to) {
+				check->first_failure = min (check->first_failure, f);
 			}
 		}
 
-		LOG_GENERAL ("Have existing frame %1", _first_nonexistant_frame);
-		++_first_nonexistant_frame;
+		fclose (mxf);
+	} else {
+		boost::mutex::scoped_lock lm (check->mutex);
+		LOG_GENERAL ("Could not open existing MXF at %1 (errno=%2)", check->mxf.string(), errno);
+		/* Be safe and re-encode everything */
+		check->first_failure = check->from;
 	}
 
-	fclose (mxf);
+	boost::mutex::scoped_lock lm (check->mutex);
+	--check->running;
+	check->condition.notify_all ();
 }
 
 /** @param frame Frame index.
@@ -638,30 +1233,26 @@ Writer::check_existing_picture_mxf ()
 bool
 Writer::can_fake_write (int frame) const
 {
-	/* We have to do a proper write of the first frame so that we can set up the JPEG2000
-	   parameters in the MXF writer.
+	/* We have to do a proper write of the first frame of each reel so that we can set up
+	   the JPEG2000 parameters in the MXF writer.
 	*/
-	return (frame != 0 && frame < _first_nonexistant_frame);
+	return (frame < _first_nonexistant_frame && frame != _reels[reel_index (frame)].from);
 }
 
-bool
-operator< (QueueItem const & a, QueueItem const & b)
+void
+Writer::set_encoder_threads (int threads)
 {
-	if (a.frame != b.frame) {
-		return a.frame < b.frame;
-	}
-
-	return static_cast<int> (a.eyes) < static_cast<int> (b.eyes);
+	boost::mutex::scoped_lock lock (_mutex);
+	_minimum_frames_in_memory = rint (threads * 1.1);
 }
 
+/** @return true if we are holding more frames in memory than our budget allows.
+ *  We always allow ourselves a few frames, however tight things are, so that
+ *  we are not constantly pushing frames to disk only to read them straight back.
+ *  _mutex must be held.
+ */
 bool
-operator== (QueueItem const & a, QueueItem const & b)
-{
-	return a.frame == b.frame && a.eyes == b.eyes;
-}
-
-void
-Writer::set_encoder_threads (int threads)
+Writer::over_memory_budget () const
 {
-	_maximum_frames_in_memory = rint (threads * 1.1);
+	return _queued_full_in_memory > _minimum_frames_in_memory && _memory->over ();
 }
@@ -18,6 +18,9 @@
 */
 
 #include <list>
+#include <map>
+#include <set>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/condition.hpp>
@@ -28,6 +31,10 @@ class Film;
 class EncodedData;
 class AudioBuffers;
 class Job;
+class SpillLog;
+class MemoryBudget;
+class FrameInfoIndex;
+struct ExistingFrameCheck;
 
 namespace libdcp {
 	class MonoPictureAsset;
@@ -40,6 +47,11 @@ namespace libdcp {
 	class SoundAssetWriter;
 }
 
+/** Frame index and eyes of a QueueItem; these sort in the order that frames must
+ *  be written, with EYES_LEFT before EYES_RIGHT for 3D.
+ */
+typedef std::pair<int, Eyes> QueueKey;
+
 struct QueueItem
 {
 public:
@@ -62,15 +74,47 @@ public:
 	/** frame index */
 	int frame;
 	Eyes eyes;
+
+	QueueKey key () const {
+		return std::make_pair (frame, eyes);
+	}
 };
 
-bool operator< (QueueItem const & a, QueueItem const & b);
-bool operator== (QueueItem const & a, QueueItem const & b);
+/** State of one of the reels that a Writer is making */
+struct WriterReel
+{
+	WriterReel (int f, int t)
+		: from (f)
+		, to (t)
+		, picture_done (false)
+		, sound_done (false)
+		, finisher (0)
+	{}
+
+	/** first video frame in this reel */
+	int from;
+	/** last video frame in this reel + 1 */
+	int to;
+
+	boost::shared_ptr<libdcp::PictureAsset> picture_asset;
+	/** writer for picture_asset; 0 until the first frame of this reel is written */
+	boost::shared_ptr<libdcp::PictureAssetWriter> picture_asset_writer;
+	boost::shared_ptr<libdcp::SoundAsset> sound_asset;
+	/** writer for sound_asset; 0 until the first audio for this reel is written */
+	boost::shared_ptr<libdcp::SoundAssetWriter> sound_asset_writer;
+
+	/** true if all this reel's picture data has been written */
+	bool picture_done;
+	/** true if all this reel's sound data has been written */
+	bool sound_done;
+	/** thread which is finishing this reel, or 0 */
+	boost::thread* finisher;
+};
 
 class Writer : public ExceptionStore, public boost::noncopyable
 {
 public:
-	Writer (boost::shared_ptr<const Film>, boost::weak_ptr<Job>);
+	Writer (boost::shared_ptr<const Film>, boost::weak_ptr<Job>, boost::shared_ptr<MemoryBudget>);
 	~Writer ();
 
 	bool can_fake_write (int) const;
@@ -86,14 +130,32 @@ public:
 private:
 
 	void thread ();
+	void audio_thread ();
 	void terminate_thread (bool);
+	void write_audio (AudioBuffers const *, int);
+	int reel_index (int) const;
+	void maybe_finish_reel (int);
+	void finish_reel_in_background (int);
+	void finish_reel (int, int, boost::shared_ptr<Job>);
+	void compute_sound_digest (boost::shared_ptr<libdcp::SoundAsset>);
 	void check_existing_picture_mxf ();
+	int check_existing_picture_mxf (WriterReel const &);
+	void check_existing_picture_mxf_thread (ExistingFrameCheck *);
 	bool check_existing_picture_mxf_frame (FILE *, int, Eyes);
-	bool have_sequenced_image_at_queue_head ();
+	bool existing_picture_mxf_frame_present (int, int64_t) const;
+	bool have_sequenced_image_at_queue_head () const;
+	bool over_memory_budget () const;
+	void add_to_queue (QueueItem const &);
+	void charge (boost::shared_ptr<const EncodedData>);
+	void discharge (boost::shared_ptr<const EncodedData>);
+	void wait_for_space (boost::mutex::scoped_lock &);
+	void add_picture_write_time (struct timeval);
 
 	/** our Film */
 	boost::shared_ptr<const Film> _film;
 	boost::weak_ptr<Job> _job;
+	/** account of the memory used by frames in this encode, shared with the Encoder */
+	boost::shared_ptr<MemoryBudget> _memory;
 	/** the first frame index that does not already exist in our MXF */
 	int _first_nonexistant_frame;
 
@@ -101,10 +163,16 @@ private:
 	boost::thread* _thread;
 	/** true if our thread should finish */
 	bool _finish;
-	/** queue of things to write to disk */
-	std::list<QueueItem> _queue;
+	/** queue of things to write to disk, kept in the order that they must be written */
+	std::map<QueueKey, QueueItem> _queue;
 	/** number of FULL frames whose JPEG200 data is currently held in RAM */
 	int _queued_full_in_memory;
+	/** keys of the FULL frames in _queue whose JPEG2000 data is held in RAM, so that
+	    we can find the furthest one quickly when we need to push some to disk.
+	*/
+	std::set<QueueKey> _full_in_memory;
+	/** number of items in _queue which hold each piece of EncodedData in memory */
+	std::map<EncodedData const *, int> _charges;
 	/** mutex for thread state */
 	mutable boost::mutex _mutex;
 	/** condition to manage thread wakeups when we have nothing to do  */
@@ -116,10 +184,10 @@ private:
 	/** the index of the last written frame */
 	int _last_written_frame;
 	Eyes _last_written_eyes;
-	/** maximum number of frames to hold in memory, for when we are managing
-	    ordering
+	/** number of frames that we will always hold in memory, whatever _memory says,
+	    for when we are managing ordering
 	*/
-	int _maximum_frames_in_memory;
+	int _minimum_frames_in_memory;
 
 	/** number of FULL written frames */
 	int _full_written;
@@ -131,9 +199,36 @@ private:
 	    due to the limit of frames to be held in memory.
 	*/
 	int _pushed_to_disk;
-
-	boost::shared_ptr<libdcp::PictureAsset> _picture_asset;
-	boost::shared_ptr<libdcp::PictureAssetWriter> _picture_asset_writer;
-	boost::shared_ptr<libdcp::SoundAsset> _sound_asset;
-	boost::shared_ptr<libdcp::SoundAssetWriter> _sound_asset_writer;
+	/** time that our thread has spent writing to the picture MXF, in seconds */
+	double _picture_writing;
+	/** number of times that a caller has had to wait for the queue to drain */
+	int _waits_for_space;
+	/** total time that callers have spent waiting for the queue to drain, in seconds */
+	double _waiting_for_space;
+
+	/** thread to write audio to our reels' sound assets, or 0 */
+	boost::thread* _audio_thread;
+	/** audio waiting to be written by _audio_thread */
+	std::list<boost::shared_ptr<const AudioBuffers> > _audio_queue;
+	/** total number of frames in _audio_queue */
+	int _audio_queued_frames;
+	/** true if _audio_thread should finish once _audio_queue is empty */
+	bool _audio_finish;
+	/** mutex for the audio state above */
+	boost::mutex _audio_mutex;
+	/** condition to signal changes to the audio state */
+	boost::condition _audio_condition;
+	/** index into _reels of the reel that _audio_thread is writing to */
+	int _audio_reel;
+	/** number of audio frames that _audio_thread has written */
+	int64_t _audio_frames_written;
+	/** where frames are pushed to disk; only used by our thread */
+	boost::shared_ptr<SpillLog> _spill;
+	/** offsets, sizes and hashes of the frames in our picture MXF */
+	boost::shared_ptr<FrameInfoIndex> _frame_info;
+
+	/** the reels that we are writing, in order; this vector is not changed after construction */
+	std::vector<WriterReel> _reels;
+	/** mutex for the picture_done, sound_done and finisher members of _reels */
+	boost::mutex _reels_mutex;
 };
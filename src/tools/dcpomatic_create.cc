@@ -172,14 +172,16 @@ main (int argc, char* argv[])
 		film->set_container (container_ratio);
 		film->set_dcp_content_type (dcp_content_type);
 
+		ContentList to_add;
 		for (int i = optind; i < argc; ++i) {
 			shared_ptr<Content> c = content_factory (film, argv[i]);
 			shared_ptr<VideoContent> vc = dynamic_pointer_cast<VideoContent> (c);
 			if (vc) {
 				vc->set_scale (VideoContentScale (content_ratio));
 			}
-			film->examine_and_add_content (c);
+			to_add.push_back (c);
 		}
+		film->examine_and_add_content (to_add);
 
 		JobManager* jm = JobManager::instance ();
 
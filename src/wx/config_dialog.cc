@@ -818,10 +818,65 @@ private:
 			table->Add (s, 1);
 		}
 
+		{
+			add_label_to_sizer (table, panel, _("Memory for frames"), true);
+			wxBoxSizer* s = new wxBoxSizer (wxHORIZONTAL);
+			_memory_budget = new wxSpinCtrl (panel);
+			s->Add (_memory_budget, 1);
+			add_label_to_sizer (s, panel, _("MB"), false);
+			table->Add (s, 1);
+		}
+
+		add_label_to_sizer (table, panel, _("Maximum CPU-heavy jobs"), true);
+		_maximum_jobs[JOB_RESOURCE_CPU] = new wxSpinCtrl (panel);
+		table->Add (_maximum_jobs[JOB_RESOURCE_CPU], 1);
+
+		add_label_to_sizer (table, panel, _("Maximum disk-heavy jobs"), true);
+		_maximum_jobs[JOB_RESOURCE_DISK] = new wxSpinCtrl (panel);
+		table->Add (_maximum_jobs[JOB_RESOURCE_DISK], 1);
+
+		add_label_to_sizer (table, panel, _("Maximum network jobs"), true);
+		_maximum_jobs[JOB_RESOURCE_NETWORK] = new wxSpinCtrl (panel);
+		table->Add (_maximum_jobs[JOB_RESOURCE_NETWORK], 1);
+
+		{
+			add_label_to_sizer (table, panel, _("Content read buffer"), true);
+			wxBoxSizer* s = new wxBoxSizer (wxHORIZONTAL);
+			_content_read_buffer = new wxSpinCtrl (panel);
+			s->Add (_content_read_buffer, 1);
+			add_label_to_sizer (s, panel, _("KB"), false);
+			table->Add (s, 1);
+		}
+
+		_content_read_ahead = new wxCheckBox (panel, wxID_ANY, _("Read ahead in content files"));
+		table->Add (_content_read_ahead, 1, wxEXPAND | wxALL);
+		table->AddSpacer (0);
+
+		{
+			add_label_to_sizer (table, panel, _("Image sequence read-ahead"), true);
+			wxBoxSizer* s = new wxBoxSizer (wxHORIZONTAL);
+			_image_prefetch_depth = new wxSpinCtrl (panel);
+			s->Add (_image_prefetch_depth, 1);
+			add_label_to_sizer (s, panel, _("files"), false);
+			table->Add (s, 1);
+		}
+
+		add_label_to_sizer (table, panel, _("Image sequence files to read at once"), true);
+		_image_prefetch_threads = new wxSpinCtrl (panel);
+		table->Add (_image_prefetch_threads, 1);
+
 		_allow_any_dcp_frame_rate = new wxCheckBox (panel, wxID_ANY, _("Allow any DCP frame rate"));
 		table->Add (_allow_any_dcp_frame_rate, 1, wxEXPAND | wxALL);
 		table->AddSpacer (0);
 
+		_detect_duplicate_frames = new wxCheckBox (panel, wxID_ANY, _("Detect duplicate frames and encode them only once"));
+		table->Add (_detect_duplicate_frames, 1, wxEXPAND | wxALL);
+		table->AddSpacer (0);
+
+		_use_examination_cache = new wxCheckBox (panel, wxID_ANY, _("Remember what was found when examining content files"));
+		table->Add (_use_examination_cache, 1, wxEXPAND | wxALL);
+		table->AddSpacer (0);
+
 #ifdef __WXOSX__
 		wxStaticText* m = new wxStaticText (panel, wxID_ANY, _("Log:"));
 		table->Add (m, 0, wxALIGN_TOP | wxLEFT | wxRIGHT | wxEXPAND | wxALL | wxALIGN_RIGHT, 6);
@@ -847,7 +902,22 @@ private:
 
 		_maximum_j2k_bandwidth->SetRange (1, 1000);
 		_maximum_j2k_bandwidth->Bind (wxEVT_COMMAND_SPINCTRL_UPDATED, boost::bind (&AdvancedPage::maximum_j2k_bandwidth_changed, this));
+		_memory_budget->SetRange (64, 65536);
+		_memory_budget->Bind (wxEVT_COMMAND_SPINCTRL_UPDATED, boost::bind (&AdvancedPage::memory_budget_changed, this));
+		for (int i = 0; i < JOB_RESOURCE_COUNT; ++i) {
+			_maximum_jobs[i]->SetRange (1, 64);
+			_maximum_jobs[i]->Bind (wxEVT_COMMAND_SPINCTRL_UPDATED, boost::bind (&AdvancedPage::maximum_jobs_changed, this, static_cast<JobResource> (i)));
+		}
+		_content_read_buffer->SetRange (4, 65536);
+		_content_read_buffer->Bind (wxEVT_COMMAND_SPINCTRL_UPDATED, boost::bind (&AdvancedPage::content_read_buffer_changed, this));
+		_content_read_ahead->Bind (wxEVT_COMMAND_CHECKBOX_CLICKED, boost::bind (&AdvancedPage::content_read_ahead_changed, this));
+		_image_prefetch_depth->SetRange (0, 256);
+		_image_prefetch_depth->Bind (wxEVT_COMMAND_SPINCTRL_UPDATED, boost::bind (&AdvancedPage::image_prefetch_depth_changed, this));
+		_image_prefetch_threads->SetRange (1, 64);
+		_image_prefetch_threads->Bind (wxEVT_COMMAND_SPINCTRL_UPDATED, boost::bind (&AdvancedPage::image_prefetch_threads_changed, this));
 		_allow_any_dcp_frame_rate->Bind (wxEVT_COMMAND_CHECKBOX_CLICKED, boost::bind (&AdvancedPage::allow_any_dcp_frame_rate_changed, this));
+		_detect_duplicate_frames->Bind (wxEVT_COMMAND_CHECKBOX_CLICKED, boost::bind (&AdvancedPage::detect_duplicate_frames_changed, this));
+		_use_examination_cache->Bind (wxEVT_COMMAND_CHECKBOX_CLICKED, boost::bind (&AdvancedPage::use_examination_cache_changed, this));
 		_log_general->Bind (wxEVT_COMMAND_CHECKBOX_CLICKED, boost::bind (&AdvancedPage::log_changed, this));
 		_log_warning->Bind (wxEVT_COMMAND_CHECKBOX_CLICKED, boost::bind (&AdvancedPage::log_changed, this));
 		_log_error->Bind (wxEVT_COMMAND_CHECKBOX_CLICKED, boost::bind (&AdvancedPage::log_changed, this));
@@ -860,7 +930,17 @@ private:
 		Config* config = Config::instance ();
 
 		checked_set (_maximum_j2k_bandwidth, config->maximum_j2k_bandwidth() / 1000000);
+		checked_set (_memory_budget, config->memory_budget ());
+		for (int i = 0; i < JOB_RESOURCE_COUNT; ++i) {
+			checked_set (_maximum_jobs[i], config->maximum_jobs (static_cast<JobResource> (i)));
+		}
+		checked_set (_content_read_buffer, config->content_read_buffer ());
+		checked_set (_content_read_ahead, config->content_read_ahead ());
+		checked_set (_image_prefetch_depth, config->image_prefetch_depth ());
+		checked_set (_image_prefetch_threads, config->image_prefetch_threads ());
 		checked_set (_allow_any_dcp_frame_rate, config->allow_any_dcp_frame_rate ());
+		checked_set (_detect_duplicate_frames, config->detect_duplicate_frames ());
+		checked_set (_use_examination_cache, config->use_examination_cache ());
 		checked_set (_log_general, config->log_types() & Log::TYPE_GENERAL);
 		checked_set (_log_warning, config->log_types() & Log::TYPE_WARNING);
 		checked_set (_log_error, config->log_types() & Log::TYPE_ERROR);
@@ -873,11 +953,51 @@ private:
 		Config::instance()->set_maximum_j2k_bandwidth (_maximum_j2k_bandwidth->GetValue() * 1000000);
 	}
 
+	void memory_budget_changed ()
+	{
+		Config::instance()->set_memory_budget (_memory_budget->GetValue ());
+	}
+
+	void maximum_jobs_changed (JobResource r)
+	{
+		Config::instance()->set_maximum_jobs (r, _maximum_jobs[r]->GetValue ());
+	}
+
+	void content_read_buffer_changed ()
+	{
+		Config::instance()->set_content_read_buffer (_content_read_buffer->GetValue ());
+	}
+
+	void content_read_ahead_changed ()
+	{
+		Config::instance()->set_content_read_ahead (_content_read_ahead->GetValue ());
+	}
+
+	void image_prefetch_depth_changed ()
+	{
+		Config::instance()->set_image_prefetch_depth (_image_prefetch_depth->GetValue ());
+	}
+
+	void image_prefetch_threads_changed ()
+	{
+		Config::instance()->set_image_prefetch_threads (_image_prefetch_threads->GetValue ());
+	}
+
 	void allow_any_dcp_frame_rate_changed ()
 	{
 		Config::instance()->set_allow_any_dcp_frame_rate (_allow_any_dcp_frame_rate->GetValue ());
 	}
 
+	void detect_duplicate_frames_changed ()
+	{
+		Config::instance()->set_detect_duplicate_frames (_detect_duplicate_frames->GetValue ());
+	}
+
+	void use_examination_cache_changed ()
+	{
+		Config::instance()->set_use_examination_cache (_use_examination_cache->GetValue ());
+	}
+
 	void log_changed ()
 	{
 		int types = 0;
@@ -900,7 +1020,15 @@ private:
 	}
 
 	wxSpinCtrl* _maximum_j2k_bandwidth;
+	wxSpinCtrl* _memory_budget;
+	wxSpinCtrl* _maximum_jobs[JOB_RESOURCE_COUNT];
+	wxSpinCtrl* _content_read_buffer;
+	wxCheckBox* _content_read_ahead;
+	wxSpinCtrl* _image_prefetch_depth;
+	wxSpinCtrl* _image_prefetch_threads;
 	wxCheckBox* _allow_any_dcp_frame_rate;
+	wxCheckBox* _detect_duplicate_frames;
+	wxCheckBox* _use_examination_cache;
 	wxCheckBox* _log_general;
 	wxCheckBox* _log_warning;
 	wxCheckBox* _log_error;
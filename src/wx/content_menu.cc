@@ -237,7 +237,7 @@ ContentMenu::find_missing ()
 		return;
 	}
 
-	shared_ptr<Job> j (new ExamineContentJob (film, content));
+	shared_ptr<Job> j (new ExamineContentJob (film, ContentList (1, content)));
 
 	_job_connection = j->Finished.connect (
 		bind (
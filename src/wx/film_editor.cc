@@ -234,6 +234,21 @@ FilmEditor::make_dcp_panel ()
 	grid->Add (_standard, wxGBPosition (r, 1), wxDefaultSpan, wxALIGN_CENTER_VERTICAL);
 	++r;
 
+	add_label_to_grid_bag_sizer (grid, _dcp_panel, _("Reels"), true, wxGBPosition (r, 0));
+	_reel_type = new wxChoice (_dcp_panel, wxID_ANY);
+	grid->Add (_reel_type, wxGBPosition (r, 1), wxDefaultSpan, wxALIGN_CENTER_VERTICAL);
+	++r;
+
+	{
+		add_label_to_grid_bag_sizer (grid, _dcp_panel, _("Reel length"), true, wxGBPosition (r, 0));
+		wxSizer* s = new wxBoxSizer (wxHORIZONTAL);
+		_reel_length = new wxSpinCtrl (_dcp_panel, wxID_ANY);
+		s->Add (_reel_length, 1);
+		add_label_to_sizer (s, _dcp_panel, _("GB"), false);
+		grid->Add (s, wxGBPosition (r, 1));
+	}
+	++r;
+
 	add_label_to_grid_bag_sizer (grid, _dcp_panel, _("Scaler"), true, wxGBPosition (r, 0));
 	_scaler = new wxChoice (_dcp_panel, wxID_ANY);
 	grid->Add (_scaler, wxGBPosition (r, 1), wxDefaultSpan, wxALIGN_CENTER_VERTICAL);
@@ -267,6 +282,12 @@ FilmEditor::make_dcp_panel ()
 
 	_standard->Append (_("SMPTE"));
 	_standard->Append (_("Interop"));
+
+	_reel_type->Append (_("Single reel"));
+	_reel_type->Append (_("Split by video content"));
+	_reel_type->Append (_("Split by length"));
+
+	_reel_length->SetRange (1, 64);
 }
 
 void
@@ -302,6 +323,8 @@ FilmEditor::connect_to_widgets ()
 	_resolution->Bind       (wxEVT_COMMAND_CHOICE_SELECTED,       boost::bind (&FilmEditor::resolution_changed, this));
 	_three_d->Bind	 	(wxEVT_COMMAND_CHECKBOX_CLICKED,      boost::bind (&FilmEditor::three_d_changed, this));
 	_standard->Bind         (wxEVT_COMMAND_CHOICE_SELECTED,       boost::bind (&FilmEditor::standard_changed, this));
+	_reel_type->Bind        (wxEVT_COMMAND_CHOICE_SELECTED,       boost::bind (&FilmEditor::reel_type_changed, this));
+	_reel_length->Bind      (wxEVT_COMMAND_SPINCTRL_UPDATED,      boost::bind (&FilmEditor::reel_length_changed, this));
 }
 
 void
@@ -473,6 +496,26 @@ FilmEditor::standard_changed ()
 	_film->set_interop (_standard->GetSelection() == 1);
 }
 
+void
+FilmEditor::reel_type_changed ()
+{
+	if (!_film) {
+		return;
+	}
+
+	_film->set_reel_type (static_cast<ReelType> (_reel_type->GetSelection ()));
+}
+
+void
+FilmEditor::reel_length_changed ()
+{
+	if (!_film) {
+		return;
+	}
+
+	_film->set_reel_length (int64_t (_reel_length->GetValue ()) * 1000000000);
+}
+
 /** Called when the metadata stored in the Film object has changed;
  *  so that we can update the GUI.
  *  @param p Property of the Film that has changed.
@@ -582,6 +625,13 @@ FilmEditor::film_changed (Film::Property p)
 		checked_set (_standard, _film->interop() ? 1 : 0);
 		setup_dcp_name ();
 		break;
+	case Film::REEL_TYPE:
+		checked_set (_reel_type, _film->reel_type ());
+		_reel_length->Enable (_generally_sensitive && _film->reel_type() == REELTYPE_BY_LENGTH);
+		break;
+	case Film::REEL_LENGTH:
+		checked_set (_reel_length, _film->reel_length() / 1000000000);
+		break;
 	default:
 		break;
 	}
@@ -705,6 +755,8 @@ FilmEditor::set_film (shared_ptr<Film> f)
 	film_changed (Film::AUDIO_CHANNELS);
 	film_changed (Film::THREE_D);
 	film_changed (Film::INTEROP);
+	film_changed (Film::REEL_TYPE);
+	film_changed (Film::REEL_LENGTH);
 
 	if (!_film->content().empty ()) {
 		set_selection (_film->content().front ());
@@ -751,6 +803,8 @@ FilmEditor::set_general_sensitivity (bool s)
 	_scaler->Enable (s);
 	_three_d->Enable (s);
 	_standard->Enable (s);
+	_reel_type->Enable (s);
+	_reel_length->Enable (s && _film && _film->reel_type() == REELTYPE_BY_LENGTH);
 
 	/* Set the panels in the content notebook */
 	for (list<FilmEditorPanel*>::iterator i = _panels.begin(); i != _panels.end(); ++i) {
@@ -925,16 +979,18 @@ FilmEditor::add_files (list<string> path_list)
 
 	path_list.sort (ImageFilenameSorter ());
 
-	/* XXX: check for lots of files here and do something */
-
+	ContentList content;
 	for (list<string>::const_iterator i = path_list.begin(); i != path_list.end(); ++i) {
 		shared_ptr<Content> c = content_factory (_film, *i);
 		shared_ptr<ImageContent> ic = dynamic_pointer_cast<ImageContent> (c);
 		if (ic) {
 			ic->set_video_frame_rate (24);
 		}
-		_film->examine_and_add_content (c);
+		content.push_back (c);
 	}
+
+	/* Examine everything in one go so that it can be done in parallel */
+	_film->examine_and_add_content (content);
 }
 
 void
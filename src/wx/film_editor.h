@@ -97,6 +97,8 @@ private:
 	void content_timeline_clicked ();
 	void audio_channels_changed ();
 	void resolution_changed ();
+	void reel_type_changed ();
+	void reel_length_changed ();
 	void content_right_click (wxListEvent &);
 	void three_d_changed ();
 	void standard_changed ();
@@ -161,6 +163,8 @@ private:
 	wxCheckBox* _three_d;
 	wxChoice* _resolution;
 	wxChoice* _standard;
+	wxChoice* _reel_type;
+	wxSpinCtrl* _reel_length;
 	wxCheckBox* _signed;
 	wxCheckBox* _encrypted;
 	wxStaticText* _key;
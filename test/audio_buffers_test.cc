@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file  test/audio_buffers_test.cc
+ *  @brief Tests of AudioBuffers' storage.
+ */
+
+#include <stdint.h>
+#include <boost/test/unit_test.hpp>
+#include "lib/audio_buffers.h"
+
+using boost::shared_ptr;
+
+static void
+fill (AudioBuffers& b)
+{
+	for (int i = 0; i < b.channels(); ++i) {
+		for (int j = 0; j < b.frames(); ++j) {
+			b.data(i)[j] = i * 1000 + j;
+		}
+	}
+}
+
+/** Every channel should start on a 64-byte boundary, whatever the number of frames */
+BOOST_AUTO_TEST_CASE (audio_buffers_alignment_test)
+{
+	for (int frames = 0; frames < 100; ++frames) {
+		AudioBuffers b (6, frames);
+		for (int i = 0; i < b.channels(); ++i) {
+			BOOST_CHECK_EQUAL (reinterpret_cast<uintptr_t> (b.data(i)) % 64, 0);
+		}
+	}
+}
+
+/** Growing some buffers must keep what was in them and make the new space silent */
+BOOST_AUTO_TEST_CASE (audio_buffers_ensure_size_test)
+{
+	AudioBuffers b (4, 10);
+	fill (b);
+
+	/* This should fit into the block that we have */
+	b.ensure_size (200);
+	/* And this should need a new one */
+	b.ensure_size (100000);
+
+	for (int i = 0; i < b.channels(); ++i) {
+		BOOST_CHECK_EQUAL (reinterpret_cast<uintptr_t> (b.data(i)) % 64, 0);
+		for (int j = 0; j < 10; ++j) {
+			BOOST_REQUIRE_EQUAL (b.data(i)[j], i * 1000 + j);
+		}
+		for (int j = 10; j < 100000; ++j) {
+			BOOST_REQUIRE_EQUAL (b.data(i)[j], 0);
+		}
+	}
+}
+
+/** A view should see its parent's data, and stay valid after the parent has gone */
+BOOST_AUTO_TEST_CASE (audio_buffers_view_test)
+{
+	shared_ptr<const AudioBuffers> view;
+
+	{
+		shared_ptr<AudioBuffers> b (new AudioBuffers (3, 500));
+		fill (*b.get());
+		view = b->view (100, 50);
+		BOOST_CHECK_EQUAL (view->data(0), b->data(0) + 100);
+
+		/* The parent must not move its data about underneath the view */
+		float* before = b->data (1);
+		b->ensure_size (600);
+		BOOST_CHECK (b->data(1) != before);
+	}
+
+	BOOST_REQUIRE_EQUAL (view->channels(), 3);
+	BOOST_REQUIRE_EQUAL (view->frames(), 50);
+	for (int i = 0; i < view->channels(); ++i) {
+		for (int j = 0; j < view->frames(); ++j) {
+			BOOST_REQUIRE_EQUAL (view->data(i)[j], i * 1000 + j + 100);
+		}
+	}
+
+	/* A copy of a view is a real AudioBuffers */
+	AudioBuffers copy (view);
+	BOOST_CHECK_EQUAL (copy.frames(), 50);
+	BOOST_CHECK_EQUAL (copy.data(2)[0], 2100);
+}
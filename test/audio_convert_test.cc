@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file  test/audio_convert_test.cc
+ *  @brief Tests of conversion of audio samples to float.
+ */
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "lib/audio_convert.h"
+
+using std::vector;
+
+/** Deinterleave some samples with the simple method and compare with deinterleave_samples */
+template <typename T>
+static void
+check_deinterleave (int channels, int frames, float scale, float offset)
+{
+	vector<T> in (channels * frames);
+	for (size_t i = 0; i < in.size(); ++i) {
+		in[i] = static_cast<T> (i * 7919);
+	}
+
+	vector<vector<float> > out (channels, vector<float> (frames));
+	vector<float*> out_ptr (channels);
+	for (int i = 0; i < channels; ++i) {
+		out_ptr[i] = &out[i][0];
+	}
+
+	deinterleave_samples (&in[0], channels, frames, &out_ptr[0]);
+
+	for (int i = 0; i < frames; ++i) {
+		for (int j = 0; j < channels; ++j) {
+			BOOST_REQUIRE_EQUAL (out[j][i], (float (in[i * channels + j]) - offset) / scale);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE (audio_deinterleave_test)
+{
+	/* Try the channel counts that have their own code, and some that do not, with
+	   numbers of frames either side of the block size.
+	*/
+	int const channels[] = { 1, 2, 3, 6, 8, 12, 16 };
+	int const frames[] = { 0, 1, 255, 256, 257, 1000 };
+
+	for (size_t i = 0; i < sizeof (channels) / sizeof (int); ++i) {
+		for (size_t j = 0; j < sizeof (frames) / sizeof (int); ++j) {
+			check_deinterleave<uint8_t> (channels[i], frames[j], 128, 128);
+			check_deinterleave<int16_t> (channels[i], frames[j], 32768, 0);
+			check_deinterleave<int32_t> (channels[i], frames[j], 2147483648.0f, 0);
+			check_deinterleave<float> (channels[i], frames[j], 1, 0);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE (audio_convert_test)
+{
+	uint8_t const u8[] = { 0, 128, 255 };
+	int16_t const s16[] = { -32768, 0, 32767 };
+	int32_t const s32[] = { -2147483647 - 1, 0, 1 << 30 };
+	float out[3];
+
+	convert_samples (u8, 3, out);
+	BOOST_CHECK_EQUAL (out[0], -1);
+	BOOST_CHECK_EQUAL (out[1], 0);
+	BOOST_CHECK_CLOSE (out[2], 127.0 / 128, 1e-4);
+
+	convert_samples (s16, 3, out);
+	BOOST_CHECK_EQUAL (out[0], -1);
+	BOOST_CHECK_EQUAL (out[1], 0);
+	BOOST_CHECK_CLOSE (out[2], 32767.0 / 32768, 1e-4);
+
+	/* Positive samples must stay positive */
+	convert_samples (s32, 3, out);
+	BOOST_CHECK_EQUAL (out[0], -1);
+	BOOST_CHECK_EQUAL (out[1], 0);
+	BOOST_CHECK_EQUAL (out[2], 0.5);
+}
@@ -17,8 +17,10 @@
 
 */
 
+#include <cmath>
 #include <boost/test/unit_test.hpp>
 #include "lib/audio_mapping.h"
+#include "lib/audio_buffers.h"
 #include "lib/util.h"
 
 /* Basic tests of the AudioMapping class, which itself
@@ -42,3 +44,55 @@ BOOST_AUTO_TEST_CASE (audio_mapping_test)
 	four.set (0, libdcp::RIGHT, 1);
 	BOOST_CHECK_EQUAL (four.get (0, libdcp::RIGHT), 1);
 }
+
+/** Check that AudioMixingPlan mixes in the same way as the simple method */
+BOOST_AUTO_TEST_CASE (audio_mixing_plan_test)
+{
+	int const content_channels = 3;
+	int const dcp_channels = 6;
+	int const frames = 1001;
+
+	AudioMapping mapping (content_channels);
+	mapping.make_default (content_channels);
+	/* Fold channel 2 into left and right, and leave LFE unmapped */
+	mapping.set (2, libdcp::LEFT, 0.5);
+	mapping.set (2, libdcp::RIGHT, 0.25);
+	/* Negative gains are ignored */
+	mapping.set (0, libdcp::RS, -1);
+
+	AudioBuffers in (content_channels, frames);
+	for (int i = 0; i < content_channels; ++i) {
+		for (int j = 0; j < frames; ++j) {
+			in.data(i)[j] = (i + 1) * 0.01 + j * 1e-4;
+		}
+	}
+
+	float const gain = 6;
+	float const linear = pow (10, gain / 20);
+
+	AudioMixingPlan plan (mapping, gain, dcp_channels);
+
+	AudioBuffers out (dcp_channels, frames);
+	/* Make sure that the plan writes everything */
+	for (int i = 0; i < dcp_channels; ++i) {
+		for (int j = 0; j < frames; ++j) {
+			out.data(i)[j] = 42;
+		}
+	}
+
+	plan.run (&in, &out);
+	BOOST_CHECK_EQUAL (out.frames(), frames);
+
+	for (int i = 0; i < dcp_channels; ++i) {
+		for (int j = 0; j < frames; ++j) {
+			float ref = 0;
+			for (int k = 0; k < content_channels; ++k) {
+				float const g = mapping.get (k, static_cast<libdcp::Channel> (i));
+				if (g > 0) {
+					ref += in.data(k)[j] * g * linear;
+				}
+			}
+			BOOST_REQUIRE_CLOSE (out.data(i)[j] + 1, ref + 1, 1e-4);
+		}
+	}
+}
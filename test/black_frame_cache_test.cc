@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file  test/black_frame_cache_test.cc
+ *  @brief Tests of BlackFrameCache.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "lib/black_frame_cache.h"
+#include "lib/dcp_video_frame.h"
+#include "lib/player_video_frame.h"
+#include "lib/image_proxy.h"
+#include "lib/image.h"
+#include "lib/scaler.h"
+#include "lib/log.h"
+
+using boost::shared_ptr;
+
+static shared_ptr<PlayerVideoFrame>
+black_frame (Eyes eyes)
+{
+	shared_ptr<Image> image (new Image (PIX_FMT_RGB24, libdcp::Size (1998, 1080), true));
+	image->make_black ();
+
+	shared_ptr<PlayerVideoFrame> pvf (
+		new PlayerVideoFrame (
+			shared_ptr<ImageProxy> (new RawImageProxy (image, shared_ptr<Log> ())),
+			Crop (),
+			libdcp::Size (1998, 1080),
+			libdcp::Size (1998, 1080),
+			Scaler::from_id ("bicubic"),
+			eyes,
+			PART_WHOLE,
+			ColourConversion ()
+			)
+		);
+
+	pvf->set_black ();
+	return pvf;
+}
+
+/** Check that what we put in the cache comes back out for the same key, and only for that */
+BOOST_AUTO_TEST_CASE (black_frame_cache_test)
+{
+	BlackFrameCache* cache = BlackFrameCache::instance ();
+
+	/* Use a bandwidth that no other test will */
+	int const bandwidth = 123000000;
+
+	shared_ptr<PlayerVideoFrame> both = black_frame (EYES_BOTH);
+	BOOST_CHECK (!cache->get (both, 24, bandwidth, RESOLUTION_2K, false));
+
+	uint8_t data[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	shared_ptr<const EncodedData> encoded (new LocallyEncodedData (data, sizeof (data)));
+	cache->add (both, 24, bandwidth, RESOLUTION_2K, false, encoded);
+
+	/* Same key, even with a different frame */
+	shared_ptr<const EncodedData> hit = cache->get (black_frame (EYES_BOTH), 24, bandwidth, RESOLUTION_2K, false);
+	BOOST_REQUIRE (hit);
+	BOOST_REQUIRE_EQUAL (hit->size(), encoded->size());
+	BOOST_CHECK (memcmp (hit->data(), data, sizeof (data)) == 0);
+
+	/* Different keys */
+	BOOST_CHECK (!cache->get (both, 25, bandwidth, RESOLUTION_2K, false));
+	BOOST_CHECK (!cache->get (both, 24, bandwidth + 1, RESOLUTION_2K, false));
+	BOOST_CHECK (!cache->get (both, 24, bandwidth, RESOLUTION_4K, false));
+	BOOST_CHECK (!cache->get (both, 24, bandwidth, RESOLUTION_2K, true));
+
+	/* One eye of a 3D pair has half the bandwidth, so it is different to a 2D frame... */
+	BOOST_CHECK (!cache->get (black_frame (EYES_LEFT), 24, bandwidth, RESOLUTION_2K, false));
+
+	/* ...but the two eyes are the same as each other */
+	uint8_t eye_data[] = { 9, 10, 11 };
+	shared_ptr<const EncodedData> eye (new LocallyEncodedData (eye_data, sizeof (eye_data)));
+	cache->add (black_frame (EYES_LEFT), 24, bandwidth, RESOLUTION_2K, false, eye);
+	hit = cache->get (black_frame (EYES_RIGHT), 24, bandwidth, RESOLUTION_2K, false);
+	BOOST_REQUIRE (hit);
+	BOOST_REQUIRE_EQUAL (hit->size(), eye->size());
+	BOOST_CHECK (memcmp (hit->data(), eye_data, sizeof (eye_data)) == 0);
+}
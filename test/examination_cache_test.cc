@@ -0,0 +1,100 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file test/examination_cache_test.cc
+ *  @brief Test the ExaminationCache.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "lib/examination_cache.h"
+#include "lib/ffmpeg_content.h"
+#include "lib/film.h"
+#include "lib/config.h"
+#include "lib/cross.h"
+#include "test.h"
+
+using std::vector;
+using boost::shared_ptr;
+
+/** Check that a second examination of the same file gives the same answers as the first,
+ *  and that changing the file stops us using what we remembered about it.
+ */
+BOOST_AUTO_TEST_CASE (examination_cache_test)
+{
+	shared_ptr<Film> film = new_test_film ("examination_cache_test");
+
+	boost::filesystem::path const p = "build/test/examination_cache_test.mp4";
+	boost::filesystem::remove (p);
+	boost::filesystem::copy_file ("test/data/test.mp4", p);
+
+	shared_ptr<FFmpegContent> a (new FFmpegContent (film, p));
+	film->examine_and_add_content (a);
+	wait_for_jobs ();
+
+	vector<boost::filesystem::path> paths;
+	paths.push_back (p);
+	BOOST_REQUIRE (ExaminationCache::instance()->digest (paths));
+	BOOST_CHECK_EQUAL (ExaminationCache::instance()->digest(paths).get(), a->digest ());
+	BOOST_CHECK (ExaminationCache::instance()->examination (paths));
+
+	shared_ptr<FFmpegContent> b (new FFmpegContent (film, p));
+	film->examine_and_add_content (b);
+	wait_for_jobs ();
+
+	BOOST_CHECK_EQUAL (b->digest(), a->digest ());
+	BOOST_CHECK_EQUAL (b->video_length(), a->video_length ());
+	BOOST_CHECK_EQUAL (b->video_size().width, a->video_size().width);
+	BOOST_CHECK_EQUAL (b->video_size().height, a->video_size().height);
+	BOOST_CHECK_EQUAL (b->video_frame_rate(), a->video_frame_rate ());
+	BOOST_CHECK_EQUAL (b->ffmpeg_audio_streams().size(), a->ffmpeg_audio_streams().size());
+	BOOST_CHECK_EQUAL (b->subtitle_streams().size(), a->subtitle_streams().size());
+	BOOST_CHECK (b->first_video() == a->first_video());
+
+	/* Change the file; we should no longer have anything for it */
+	FILE* f = fopen_boost (p, "ab");
+	BOOST_REQUIRE (f);
+	fputc (0, f);
+	fclose (f);
+
+	BOOST_CHECK (!ExaminationCache::instance()->digest (paths));
+	BOOST_CHECK (!ExaminationCache::instance()->examination (paths));
+}
+
+/** Check that nothing is remembered when the cache is turned off */
+BOOST_AUTO_TEST_CASE (examination_cache_off_test)
+{
+	shared_ptr<Film> film = new_test_film ("examination_cache_off_test");
+
+	boost::filesystem::path const p = "build/test/examination_cache_off_test.mp4";
+	boost::filesystem::remove (p);
+	boost::filesystem::copy_file ("test/data/test.mp4", p);
+
+	Config::instance()->set_use_examination_cache (false);
+
+	shared_ptr<FFmpegContent> a (new FFmpegContent (film, p));
+	film->examine_and_add_content (a);
+	wait_for_jobs ();
+
+	Config::instance()->set_use_examination_cache (true);
+
+	vector<boost::filesystem::path> paths;
+	paths.push_back (p);
+	BOOST_CHECK (!ExaminationCache::instance()->digest (paths));
+	BOOST_CHECK (!ExaminationCache::instance()->examination (paths));
+}
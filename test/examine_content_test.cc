@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file test/examine_content_test.cc
+ *  @brief Test examination of several pieces of content at once.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "lib/ffmpeg_content.h"
+#include "lib/image_content.h"
+#include "lib/sndfile_content.h"
+#include "lib/film.h"
+#include "test.h"
+
+using boost::shared_ptr;
+
+BOOST_AUTO_TEST_CASE (examine_content_test)
+{
+	shared_ptr<Film> film = new_test_film ("examine_content_test");
+
+	ContentList content;
+	content.push_back (shared_ptr<Content> (new FFmpegContent (film, "test/data/test.mp4")));
+	content.push_back (shared_ptr<Content> (new ImageContent (film, "test/data/simple_testcard_640x480.png")));
+	content.push_back (shared_ptr<Content> (new SndfileContent (film, "test/data/staircase.wav")));
+	content.push_back (shared_ptr<Content> (new FFmpegContent (film, "test/data/red_24.mp4")));
+
+	film->examine_and_add_content (content);
+	wait_for_jobs ();
+
+	/* Everything should have been added, with the video in the order that we gave it */
+	ContentList added = film->content ();
+	BOOST_CHECK_EQUAL (added.size(), 4);
+
+	for (ContentList::const_iterator i = content.begin(); i != content.end(); ++i) {
+		BOOST_CHECK (!(*i)->digest().empty ());
+	}
+
+	BOOST_CHECK_EQUAL (content[0]->position(), 0);
+	BOOST_CHECK_EQUAL (content[1]->position(), content[0]->end ());
+	BOOST_CHECK_EQUAL (content[3]->position(), content[1]->end ());
+}
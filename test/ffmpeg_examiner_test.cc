@@ -34,3 +34,20 @@ BOOST_AUTO_TEST_CASE (ffmpeg_examiner_test)
 	BOOST_CHECK_EQUAL (examiner->audio_streams().size(), 1);
 	BOOST_CHECK_EQUAL (examiner->audio_streams()[0]->first_audio.get(), 600);
 }
+
+/** Check that a short, simple file does not need much probing, and that a decoder
+ *  created after examination uses what the examination found.
+ */
+BOOST_AUTO_TEST_CASE (ffmpeg_examiner_probe_test)
+{
+	shared_ptr<Film> film = new_test_film ("ffmpeg_examiner_probe_test");
+	shared_ptr<FFmpegContent> content (new FFmpegContent (film, "test/data/test.mp4"));
+	film->examine_and_add_content (content);
+	wait_for_jobs ();
+
+	BOOST_REQUIRE (content->probe_duration ());
+	BOOST_CHECK (content->probe_duration().get() < 5 * 60 * 1000000);
+
+	shared_ptr<FFmpegExaminer> examiner (new FFmpegExaminer (content));
+	BOOST_CHECK_EQUAL (examiner->probe_duration(), content->probe_duration().get ());
+}
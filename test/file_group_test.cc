@@ -104,5 +104,17 @@ BOOST_AUTO_TEST_CASE (file_group_test)
 	BOOST_CHECK_EQUAL (fg.read (test, 256), 256);
 	BOOST_CHECK_EQUAL (memcmp (data + total_length - 1077, test, 256), 0);
 
+	/* SEEK_SET to exactly the start of a file */
+	BOOST_CHECK_EQUAL (fg.seek (length[0], SEEK_SET), length[0]);
+	BOOST_CHECK_EQUAL (fg.read (test, 64), 64);
+	BOOST_CHECK_EQUAL (memcmp (data + length[0], test, 64), 0);
+
+	/* Reading ahead should not change anything that we read */
+	fg.set_read_ahead (true);
+	BOOST_CHECK_EQUAL (fg.seek (0, SEEK_SET), 0);
+	BOOST_CHECK_EQUAL (fg.read (test, total_length), total_length);
+	BOOST_CHECK_EQUAL (memcmp (data, test, total_length), 0);
+	BOOST_CHECK_EQUAL (fg.length(), total_length);
+
 	delete[] test;
 }
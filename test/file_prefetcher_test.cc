@@ -0,0 +1,80 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file test/file_prefetcher_test.cc
+ *  @brief Test FilePrefetcher.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <boost/test/unit_test.hpp>
+#include "lib/file_prefetcher.h"
+#include "lib/raw_convert.h"
+
+using std::vector;
+using std::string;
+
+/** @return Contents that we put in test file i */
+static string
+contents (int i)
+{
+	return "This is file " + raw_convert<string> (i);
+}
+
+static bool
+check (Magick::Blob b, int i)
+{
+	string const c = contents (i);
+	return b.length() == c.length() && memcmp (b.data(), c.c_str(), c.length()) == 0;
+}
+
+/** Read files in order, then jump about as a decoder would after seeks */
+BOOST_AUTO_TEST_CASE (file_prefetcher_test)
+{
+	boost::filesystem::path const dir = "build/test/file_prefetcher_test";
+	boost::filesystem::create_directories (dir);
+
+	int const N = 32;
+	vector<boost::filesystem::path> paths;
+	for (int i = 0; i < N; ++i) {
+		boost::filesystem::path p = dir / raw_convert<string> (i);
+		FILE* f = fopen (p.string().c_str(), "wb");
+		BOOST_REQUIRE (f);
+		string const c = contents (i);
+		fwrite (c.c_str(), 1, c.length(), f);
+		fclose (f);
+		paths.push_back (p);
+	}
+
+	/* This one does not exist */
+	paths.push_back (dir / "missing");
+
+	FilePrefetcher prefetcher (paths, 4, 2);
+
+	for (int i = 0; i < N; ++i) {
+		BOOST_CHECK (check (prefetcher.get (i), i));
+	}
+
+	BOOST_CHECK (check (prefetcher.get (10), 10));
+	BOOST_CHECK (check (prefetcher.get (11), 11));
+	BOOST_CHECK (check (prefetcher.get (3), 3));
+	BOOST_CHECK (check (prefetcher.get (N - 1), N - 1));
+
+	BOOST_CHECK_THROW (prefetcher.get (N), std::exception);
+}
@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file  test/frame_info_index_test.cc
+ *  @brief Tests of FrameInfoIndex.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "lib/frame_info_index.h"
+
+using std::string;
+using boost::optional;
+
+static libdcp::FrameInfo
+info (int n)
+{
+	/* Something which looks like an MD5 hash, different for each n */
+	char hash[33];
+	snprintf (hash, sizeof (hash), "%032x", n * 7919);
+	return libdcp::FrameInfo (int64_t (n) * 1000000, n * 100 + 1, hash);
+}
+
+static void
+check (optional<libdcp::FrameInfo> got, int n)
+{
+	BOOST_REQUIRE (got);
+	libdcp::FrameInfo const wanted = info (n);
+	BOOST_CHECK_EQUAL (got->offset, wanted.offset);
+	BOOST_CHECK_EQUAL (got->size, wanted.size);
+	BOOST_CHECK_EQUAL (got->hash, wanted.hash);
+}
+
+/** What we write should come back, and what we don't should not */
+BOOST_AUTO_TEST_CASE (frame_info_index_test)
+{
+	boost::filesystem::path const p = "build/test/frame_info_index_test.info";
+	boost::filesystem::remove (p);
+
+	FrameInfoIndex index (p, 8, 4);
+
+	index.write (0, EYES_BOTH, info (0));
+	index.write (3, EYES_BOTH, info (3));
+	check (index.read (0, EYES_BOTH), 0);
+	check (index.read (3, EYES_BOTH), 3);
+
+	/* Never written, but inside the file */
+	BOOST_CHECK (!index.read (1, EYES_BOTH));
+	BOOST_CHECK (!index.read (7, EYES_BOTH));
+	/* Past the end of the file */
+	BOOST_CHECK (!index.read (1000, EYES_BOTH));
+
+	/* Overwrite */
+	index.write (3, EYES_BOTH, info (33));
+	check (index.read (3, EYES_BOTH), 33);
+}
+
+/** Writing far past the size that we asked for should make the index grow, keeping what was there */
+BOOST_AUTO_TEST_CASE (frame_info_index_grow_test)
+{
+	boost::filesystem::path const p = "build/test/frame_info_index_grow_test.info";
+	boost::filesystem::remove (p);
+
+	FrameInfoIndex index (p, 2, 1000);
+
+	index.write (0, EYES_LEFT, info (1));
+	index.write (0, EYES_RIGHT, info (2));
+	index.write (5000, EYES_RIGHT, info (3));
+	index.write (20000, EYES_LEFT, info (4));
+
+	check (index.read (0, EYES_LEFT), 1);
+	check (index.read (0, EYES_RIGHT), 2);
+	check (index.read (5000, EYES_RIGHT), 3);
+	check (index.read (20000, EYES_LEFT), 4);
+	BOOST_CHECK (!index.read (5000, EYES_LEFT));
+	BOOST_CHECK (!index.read (19999, EYES_RIGHT));
+}
+
+/** Records should still be there after the index is closed and opened again */
+BOOST_AUTO_TEST_CASE (frame_info_index_reopen_test)
+{
+	boost::filesystem::path const p = "build/test/frame_info_index_reopen_test.info";
+	boost::filesystem::remove (p);
+
+	{
+		FrameInfoIndex index (p, 4, 1000);
+		for (int i = 0; i < 10; ++i) {
+			index.write (i, EYES_BOTH, info (i));
+		}
+		index.sync ();
+	}
+
+	FrameInfoIndex index (p, 4, 1000);
+	for (int i = 0; i < 10; ++i) {
+		check (index.read (i, EYES_BOTH), i);
+	}
+	BOOST_CHECK (!index.read (10, EYES_BOTH));
+}
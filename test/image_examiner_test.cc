@@ -0,0 +1,83 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file test/image_examiner_test.cc
+ *  @brief Test examination of image files from their headers.
+ */
+
+#include <cstdio>
+#include <boost/test/unit_test.hpp>
+#include "lib/image_header.h"
+#include "lib/image_content.h"
+#include "lib/film.h"
+#include "lib/exceptions.h"
+#include "test.h"
+
+using std::string;
+using boost::shared_ptr;
+using boost::optional;
+
+BOOST_AUTO_TEST_CASE (image_header_test)
+{
+	optional<ImageHeader> h = read_image_header ("test/data/simple_testcard_640x480.png");
+	BOOST_REQUIRE (h);
+	BOOST_CHECK_EQUAL (h->size.width, 640);
+	BOOST_CHECK_EQUAL (h->size.height, 480);
+	BOOST_CHECK_EQUAL (h->depth, 8);
+
+	BOOST_CHECK (!read_image_header ("test/data/test.mp4"));
+}
+
+/** Make an image sequence, check that it examines, then spoil it with a frame of the
+ *  wrong size and check that examination finds that.
+ */
+BOOST_AUTO_TEST_CASE (image_examiner_sequence_test)
+{
+	shared_ptr<Film> film = new_test_film ("image_examiner_sequence_test");
+
+	boost::filesystem::path const dir = "build/test/image_examiner_sequence_test/frames";
+	boost::filesystem::remove_all (dir);
+	boost::filesystem::create_directories (dir);
+	for (int i = 0; i < 24; ++i) {
+		char name[64];
+		snprintf (name, sizeof (name), "%06d.png", i);
+		boost::filesystem::copy_file ("test/data/simple_testcard_640x480.png", dir / name);
+	}
+
+	shared_ptr<ImageContent> good (new ImageContent (film, dir));
+	good->examine (shared_ptr<Job> ());
+	BOOST_CHECK_EQUAL (good->video_size().width, 640);
+	BOOST_CHECK_EQUAL (good->video_size().height, 480);
+	BOOST_CHECK_EQUAL (good->video_length(), 24);
+
+	/* Make a PNG header which says 320x240 */
+	FILE* f = fopen ((dir / "000024.png").string().c_str(), "wb");
+	BOOST_REQUIRE (f);
+	uint8_t header[] = {
+		0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n',
+		0, 0, 0, 13, 'I', 'H', 'D', 'R',
+		0, 0, 0x01, 0x40, 0, 0, 0, 0xf0,
+		8, 2, 0, 0, 0
+	};
+	fwrite (header, 1, sizeof (header), f);
+	fclose (f);
+
+	shared_ptr<ImageContent> bad (new ImageContent (film, dir));
+	BOOST_CHECK_THROW (bad->examine (shared_ptr<Job> ()), DecodeError);
+}
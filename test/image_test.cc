@@ -125,6 +125,40 @@ BOOST_AUTO_TEST_CASE (compact_image_test)
 	delete u;
 }
 
+/** Check that Image::digest ignores alignment padding but notices changes to pixels */
+BOOST_AUTO_TEST_CASE (image_digest_test)
+{
+	shared_ptr<Image> a (new Image (PIX_FMT_RGB24, libdcp::Size (50, 50), true));
+	a->make_black ();
+	shared_ptr<Image> b (new Image (PIX_FMT_RGB24, libdcp::Size (50, 50), false));
+	b->make_black ();
+
+	BOOST_CHECK_EQUAL (a->digest(), b->digest());
+
+	b->data()[0][42] = 1;
+	BOOST_CHECK (a->digest() != b->digest());
+}
+
+/** Check that Image::quick_digest ignores alignment padding and looks at only some lines */
+BOOST_AUTO_TEST_CASE (image_quick_digest_test)
+{
+	shared_ptr<Image> a (new Image (PIX_FMT_RGB24, libdcp::Size (50, 50), true));
+	a->make_black ();
+	shared_ptr<Image> b (new Image (PIX_FMT_RGB24, libdcp::Size (50, 50), false));
+	b->make_black ();
+
+	BOOST_CHECK_EQUAL (a->quick_digest(), b->quick_digest());
+
+	/* Line 1 is not looked at */
+	b->data()[0][b->stride()[0] + 42] = 1;
+	BOOST_CHECK_EQUAL (a->quick_digest(), b->quick_digest());
+	BOOST_CHECK (a->digest() != b->digest());
+
+	/* Line 16 is */
+	b->data()[0][b->stride()[0] * 16 + 42] = 1;
+	BOOST_CHECK (a->quick_digest() != b->quick_digest());
+}
+
 static
 boost::shared_ptr<Image>
 read_file (string file)
@@ -21,6 +21,7 @@
 #include "lib/job.h"
 #include "lib/job_manager.h"
 #include "lib/cross.h"
+#include "lib/config.h"
 
 using std::string;
 using boost::shared_ptr;
@@ -28,8 +29,9 @@ using boost::shared_ptr;
 class TestJob : public Job
 {
 public:
-	TestJob (shared_ptr<Film> f)
+	TestJob (shared_ptr<Film> f, JobResource r = JOB_RESOURCE_CPU)
 		: Job (f)
+		, _resource (r)
 	{
 
 	}
@@ -58,6 +60,13 @@ public:
 	string json_name () const {
 		return "";
 	}
+
+	JobResource resource () const {
+		return _resource;
+	}
+
+private:
+	JobResource _resource;
 };
 
 BOOST_AUTO_TEST_CASE (job_manager_test)
@@ -74,3 +83,33 @@ BOOST_AUTO_TEST_CASE (job_manager_test)
 	dcpomatic_sleep (2);
 	BOOST_CHECK_EQUAL (a->finished_ok(), true);
 }
+
+/** Check that jobs using different resources run at the same time, and that
+ *  jobs using the same one wait for each other.
+ */
+BOOST_AUTO_TEST_CASE (job_manager_resource_test)
+{
+	shared_ptr<Film> f;
+
+	Config::instance()->set_maximum_jobs (JOB_RESOURCE_CPU, 1);
+	Config::instance()->set_maximum_jobs (JOB_RESOURCE_NETWORK, 2);
+
+	shared_ptr<TestJob> a (new TestJob (f, JOB_RESOURCE_CPU));
+	shared_ptr<TestJob> b (new TestJob (f, JOB_RESOURCE_CPU));
+	shared_ptr<TestJob> c (new TestJob (f, JOB_RESOURCE_NETWORK));
+
+	JobManager::instance()->add (a);
+	JobManager::instance()->add (b);
+	JobManager::instance()->add (c);
+	dcpomatic_sleep (2);
+	BOOST_CHECK_EQUAL (a->running (), true);
+	BOOST_CHECK_EQUAL (b->is_new (), true);
+	BOOST_CHECK_EQUAL (c->running (), true);
+
+	a->set_finished_ok ();
+	c->set_finished_ok ();
+	dcpomatic_sleep (2);
+	BOOST_CHECK_EQUAL (b->running (), true);
+	b->set_finished_ok ();
+	dcpomatic_sleep (2);
+}
@@ -0,0 +1,172 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file test/native_image_test.cc
+ *  @brief Test our own decoders for DPX and TIFF files.
+ */
+
+#include <vector>
+#include <cstring>
+#include <boost/test/unit_test.hpp>
+#include "lib/native_image.h"
+#include "lib/image.h"
+
+using std::vector;
+using boost::shared_ptr;
+
+static void
+put_16 (vector<uint8_t>& d, size_t offset, uint16_t v, bool big_endian)
+{
+	d[offset + (big_endian ? 0 : 1)] = v >> 8;
+	d[offset + (big_endian ? 1 : 0)] = v & 0xff;
+}
+
+static void
+put_32 (vector<uint8_t>& d, size_t offset, uint32_t v, bool big_endian)
+{
+	for (int i = 0; i < 4; ++i) {
+		d[offset + (big_endian ? (3 - i) : i)] = (v >> (i * 8)) & 0xff;
+	}
+}
+
+/** @return 16-bit sample at a point in a PIX_FMT_RGB48LE image */
+static int
+sample (shared_ptr<Image> image, int x, int y, int c)
+{
+	uint8_t const * p = image->data()[0] + y * image->stride()[0] + x * 6 + c * 2;
+	return p[0] | (p[1] << 8);
+}
+
+/** Decode a 10-bit packed DPX */
+BOOST_AUTO_TEST_CASE (native_image_dpx_test)
+{
+	for (int e = 0; e < 2; ++e) {
+		bool const big_endian = e == 0;
+		int const width = 4;
+		int const height = 2;
+		size_t const offset = 2048;
+
+		vector<uint8_t> d (offset + width * height * 4, 0);
+		memcpy (&d[0], big_endian ? "SDPX" : "XPDS", 4);
+		put_32 (d, 4, offset, big_endian);
+		put_16 (d, 770, 1, big_endian);
+		put_32 (d, 772, width, big_endian);
+		put_32 (d, 776, height, big_endian);
+		d[800] = 50;
+		d[803] = 10;
+		put_16 (d, 804, 1, big_endian);
+		put_32 (d, 808, offset, big_endian);
+
+		for (int i = 0; i < width * height; ++i) {
+			uint32_t const r = i * 100;
+			uint32_t const g = 1023 - i;
+			uint32_t const b = 512;
+			put_32 (d, offset + i * 4, (r << 22) | (g << 12) | (b << 2), big_endian);
+		}
+
+		shared_ptr<Image> image = decode_native_image (&d[0], d.size ());
+		BOOST_REQUIRE (image);
+		BOOST_CHECK_EQUAL (image->pixel_format(), PIX_FMT_RGB48LE);
+		BOOST_CHECK_EQUAL (image->size().width, width);
+		BOOST_CHECK_EQUAL (image->size().height, height);
+
+		for (int i = 0; i < width * height; ++i) {
+			int const r = i * 100;
+			int const g = 1023 - i;
+			BOOST_CHECK_EQUAL (sample (image, i % width, i / width, 0), (r << 6) | (r >> 4));
+			BOOST_CHECK_EQUAL (sample (image, i % width, i / width, 1), (g << 6) | (g >> 4));
+			BOOST_CHECK_EQUAL (sample (image, i % width, i / width, 2), (512 << 6) | (512 >> 4));
+		}
+	}
+}
+
+/** Decode a 16-bit uncompressed TIFF in two strips */
+BOOST_AUTO_TEST_CASE (native_image_tiff_test)
+{
+	int const width = 3;
+	int const height = 2;
+	int const entries = 9;
+	size_t const bits_offset = 8 + 2 + entries * 12 + 4;
+	size_t const data_offset = bits_offset + 6;
+
+	vector<uint8_t> d (data_offset + width * height * 6, 0);
+	d[0] = 'I';
+	d[1] = 'I';
+	d[2] = 42;
+	put_32 (d, 4, 8, false);
+	put_16 (d, 8, entries, false);
+
+	/* tag, type, count, value */
+	uint32_t tags[entries][4] = {
+		{ 256, 3, 1, width },
+		{ 257, 3, 1, height },
+		{ 258, 3, 3, bits_offset },
+		{ 259, 3, 1, 1 },
+		{ 262, 3, 1, 2 },
+		{ 273, 4, 2, 0 },
+		{ 277, 3, 1, 3 },
+		{ 278, 3, 1, 1 },
+		{ 279, 4, 2, 0 }
+	};
+
+	/* Strip offsets and counts go after the data */
+	size_t const strips_offset = d.size ();
+	d.resize (d.size() + 16);
+	tags[5][3] = strips_offset;
+	tags[8][3] = strips_offset + 8;
+	put_32 (d, strips_offset, data_offset, false);
+	put_32 (d, strips_offset + 4, data_offset + width * 6, false);
+	put_32 (d, strips_offset + 8, width * 6, false);
+	put_32 (d, strips_offset + 12, width * 6, false);
+
+	for (int i = 0; i < entries; ++i) {
+		size_t const e = 10 + i * 12;
+		put_16 (d, e, tags[i][0], false);
+		put_16 (d, e + 2, tags[i][1], false);
+		put_32 (d, e + 4, tags[i][2], false);
+		if (tags[i][1] == 3 && tags[i][2] == 1) {
+			put_16 (d, e + 8, tags[i][3], false);
+		} else {
+			put_32 (d, e + 8, tags[i][3], false);
+		}
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		put_16 (d, bits_offset + i * 2, 16, false);
+	}
+
+	for (int i = 0; i < width * height * 3; ++i) {
+		put_16 (d, data_offset + i * 2, i * 1000, false);
+	}
+
+	shared_ptr<Image> image = decode_native_image (&d[0], d.size ());
+	BOOST_REQUIRE (image);
+	BOOST_CHECK_EQUAL (image->pixel_format(), PIX_FMT_RGB48LE);
+
+	for (int i = 0; i < width * height * 3; ++i) {
+		BOOST_CHECK_EQUAL (sample (image, (i / 3) % width, (i / 3) / width, i % 3), i * 1000);
+	}
+}
+
+/** Things that we don't understand should be left to ImageMagick */
+BOOST_AUTO_TEST_CASE (native_image_unknown_test)
+{
+	vector<uint8_t> d (4096, 0);
+	BOOST_CHECK (!decode_native_image (&d[0], d.size ()));
+}
@@ -53,18 +53,16 @@ BOOST_AUTO_TEST_CASE (recover_test)
 	film->make_dcp ();
 	wait_for_jobs ();
 
-	boost::filesystem::copy_file (
-		"build/test/recover_test/video/185_2K_f9e82cfefc42c63e62aba2bcb4633cd7_24_bicubic_100000000_P_S_3D.mxf",
-		"build/test/recover_test/original.mxf"
-		);
+	boost::filesystem::path const video = film->internal_video_mxf_dir () / film->internal_video_mxf_filename (film->reels().front ());
 
-	boost::filesystem::resize_file ("build/test/recover_test/video/185_2K_f9e82cfefc42c63e62aba2bcb4633cd7_24_bicubic_100000000_P_S_3D.mxf", 2 * 1024 * 1024);
+	boost::filesystem::copy_file (video, "build/test/recover_test/original.mxf");
+	boost::filesystem::resize_file (video, 2 * 1024 * 1024);
 
 	film->make_dcp ();
 	wait_for_jobs ();
 
 	shared_ptr<libdcp::StereoPictureAsset> A (new libdcp::StereoPictureAsset ("build/test/recover_test", "original.mxf"));
-	shared_ptr<libdcp::StereoPictureAsset> B (new libdcp::StereoPictureAsset ("build/test/recover_test/video", "185_2K_f9e82cfefc42c63e62aba2bcb4633cd7_24_bicubic_100000000_P_S_3D.mxf"));
+	shared_ptr<libdcp::StereoPictureAsset> B (new libdcp::StereoPictureAsset (video.parent_path().string (), video.filename().string ()));
 
 	libdcp::EqualityOptions eq;
 	eq.mxf_names_can_differ = true;
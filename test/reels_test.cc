@@ -0,0 +1,201 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file test/reels_test.cc
+ *  @brief Test the splitting of a film into reels.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdcp/cpl.h>
+#include <libdcp/dcp.h>
+#include <libdcp/picture_asset.h>
+#include <libdcp/reel.h>
+#include <libdcp/sound_asset.h>
+#include "lib/image_content.h"
+#include "lib/dcp_content_type.h"
+#include "lib/film.h"
+#include "lib/ratio.h"
+#include "test.h"
+
+using std::list;
+using std::pair;
+using std::string;
+using boost::shared_ptr;
+
+BOOST_AUTO_TEST_CASE (reels_test)
+{
+	shared_ptr<Film> film = new_test_film ("reels_test");
+	film->set_dcp_content_type (DCPContentType::from_isdcf_name ("FTR"));
+	film->set_container (Ratio::from_id ("185"));
+	film->set_sequence_video (false);
+	shared_ptr<ImageContent> A (new ImageContent (film, "test/data/simple_testcard_640x480.png"));
+	shared_ptr<ImageContent> B (new ImageContent (film, "test/data/simple_testcard_640x480.png"));
+
+	film->examine_and_add_content (A);
+	film->examine_and_add_content (B);
+	wait_for_jobs ();
+
+	A->set_video_length (48);
+	A->set_video_frame_rate (24);
+	A->set_position (0);
+	B->set_video_length (72);
+	B->set_video_frame_rate (24);
+	B->set_position (film->video_frames_to_time (48));
+
+	/* Single reel */
+	list<pair<int, int> > r = film->reels ();
+	BOOST_CHECK_EQUAL (r.size(), 1);
+	BOOST_CHECK_EQUAL (r.front().first, 0);
+	BOOST_CHECK_EQUAL (r.front().second, 120);
+
+	/* A reel for each piece of content */
+	film->set_reel_type (REELTYPE_BY_VIDEO_CONTENT);
+	r = film->reels ();
+	BOOST_CHECK_EQUAL (r.size(), 2);
+	BOOST_CHECK_EQUAL (r.front().first, 0);
+	BOOST_CHECK_EQUAL (r.front().second, 48);
+	BOOST_CHECK_EQUAL (r.back().first, 48);
+	BOOST_CHECK_EQUAL (r.back().second, 120);
+
+	/* 100Mbit/s at 24fps is 12500000 bytes per second, so this is 2 seconds per reel */
+	film->set_j2k_bandwidth (100000000);
+	film->set_reel_type (REELTYPE_BY_LENGTH);
+	film->set_reel_length (25000000);
+	r = film->reels ();
+	BOOST_CHECK_EQUAL (r.size(), 3);
+	list<pair<int, int> >::const_iterator i = r.begin ();
+	BOOST_CHECK_EQUAL (i->first, 0);
+	BOOST_CHECK_EQUAL (i->second, 48);
+	++i;
+	BOOST_CHECK_EQUAL (i->first, 48);
+	BOOST_CHECK_EQUAL (i->second, 96);
+	++i;
+	BOOST_CHECK_EQUAL (i->first, 96);
+	BOOST_CHECK_EQUAL (i->second, 120);
+}
+
+/** Splits which would leave a reel shorter than a second should not be made */
+BOOST_AUTO_TEST_CASE (reels_test2)
+{
+	shared_ptr<Film> film = new_test_film ("reels_test2");
+	film->set_dcp_content_type (DCPContentType::from_isdcf_name ("FTR"));
+	film->set_container (Ratio::from_id ("185"));
+	film->set_sequence_video (false);
+	shared_ptr<ImageContent> A (new ImageContent (film, "test/data/simple_testcard_640x480.png"));
+	shared_ptr<ImageContent> B (new ImageContent (film, "test/data/simple_testcard_640x480.png"));
+	shared_ptr<ImageContent> C (new ImageContent (film, "test/data/simple_testcard_640x480.png"));
+
+	film->examine_and_add_content (A);
+	film->examine_and_add_content (B);
+	film->examine_and_add_content (C);
+	wait_for_jobs ();
+
+	A->set_video_length (48);
+	A->set_video_frame_rate (24);
+	A->set_position (0);
+	B->set_video_length (12);
+	B->set_video_frame_rate (24);
+	B->set_position (film->video_frames_to_time (48));
+	C->set_video_length (60);
+	C->set_video_frame_rate (24);
+	C->set_position (film->video_frames_to_time (60));
+
+	/* B is only half a second long, so it goes in with C */
+	film->set_reel_type (REELTYPE_BY_VIDEO_CONTENT);
+	list<pair<int, int> > r = film->reels ();
+	BOOST_CHECK_EQUAL (r.size(), 2);
+	BOOST_CHECK_EQUAL (r.front().first, 0);
+	BOOST_CHECK_EQUAL (r.front().second, 48);
+	BOOST_CHECK_EQUAL (r.back().first, 48);
+	BOOST_CHECK_EQUAL (r.back().second, 120);
+
+	/* 100Mbit/s at 24fps is 12500000 bytes per second, so this is 54 frames per reel,
+	   which would leave a last reel of 12 frames; that goes in with the one before.
+	*/
+	film->set_j2k_bandwidth (100000000);
+	film->set_reel_type (REELTYPE_BY_LENGTH);
+	film->set_reel_length (28125000);
+	r = film->reels ();
+	BOOST_CHECK_EQUAL (r.size(), 2);
+	BOOST_CHECK_EQUAL (r.front().first, 0);
+	BOOST_CHECK_EQUAL (r.front().second, 54);
+	BOOST_CHECK_EQUAL (r.back().first, 54);
+	BOOST_CHECK_EQUAL (r.back().second, 120);
+}
+
+/** Make a two-reel DCP and check that each reel gets its own picture and sound assets of the right length */
+BOOST_AUTO_TEST_CASE (reels_test3)
+{
+	string const film_name = "reels_test3";
+	shared_ptr<Film> film = new_test_film (film_name);
+	film->set_dcp_content_type (DCPContentType::from_isdcf_name ("FTR"));
+	film->set_container (Ratio::from_id ("185"));
+	film->set_name (film_name);
+	film->set_sequence_video (false);
+	shared_ptr<ImageContent> A (new ImageContent (film, "test/data/simple_testcard_640x480.png"));
+	shared_ptr<ImageContent> B (new ImageContent (film, "test/data/simple_testcard_640x480.png"));
+
+	film->examine_and_add_content (A);
+	film->examine_and_add_content (B);
+	wait_for_jobs ();
+
+	A->set_video_length (48);
+	A->set_video_frame_rate (24);
+	A->set_position (0);
+	B->set_video_length (72);
+	B->set_video_frame_rate (24);
+	B->set_position (film->video_frames_to_time (48));
+
+	film->set_reel_type (REELTYPE_BY_VIDEO_CONTENT);
+	list<pair<int, int> > const r = film->reels ();
+	BOOST_REQUIRE_EQUAL (r.size(), 2);
+
+	film->make_dcp ();
+	wait_for_jobs ();
+
+	/* Each reel's picture is encoded into its own MXF */
+	for (list<pair<int, int> >::const_iterator i = r.begin(); i != r.end(); ++i) {
+		BOOST_CHECK (boost::filesystem::exists (film->internal_video_mxf_dir () / film->internal_video_mxf_filename (*i)));
+	}
+
+	boost::filesystem::path path = "build/test";
+	path /= film_name;
+	path /= film->dcp_name ();
+	libdcp::DCP check (path.string ());
+	check.read ();
+
+	list<shared_ptr<libdcp::Reel> > reels = check.cpls().front()->reels ();
+	BOOST_REQUIRE_EQUAL (reels.size(), 2);
+
+	list<pair<int, int> >::const_iterator j = r.begin ();
+	for (list<shared_ptr<libdcp::Reel> >::const_iterator i = reels.begin(); i != reels.end(); ++i) {
+		int const length = j->second - j->first;
+
+		BOOST_REQUIRE ((*i)->main_picture ());
+		BOOST_CHECK_EQUAL ((*i)->main_picture()->intrinsic_duration (), length);
+		BOOST_REQUIRE ((*i)->main_sound ());
+		BOOST_CHECK_EQUAL ((*i)->main_sound()->intrinsic_duration (), length);
+
+		++j;
+	}
+
+	/* The two reels must not share assets */
+	BOOST_CHECK (reels.front()->main_picture()->uuid () != reels.back()->main_picture()->uuid ());
+	BOOST_CHECK (reels.front()->main_sound()->uuid () != reels.back()->main_sound()->uuid ());
+}
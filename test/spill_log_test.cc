@@ -0,0 +1,118 @@
+/*
+    Copyright (C) 2015 Carl Hetherington <cth@carlh.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/** @file  test/spill_log_test.cc
+ *  @brief Tests of SpillLog.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "lib/spill_log.h"
+#include "lib/dcp_video_frame.h"
+#include "lib/cross.h"
+
+using boost::shared_ptr;
+
+static shared_ptr<EncodedData>
+frame_data (int n, int size)
+{
+	shared_ptr<EncodedData> d (new EncodedData (size));
+	for (int i = 0; i < size; ++i) {
+		d->data()[i] = (n * 7 + i) % 256;
+	}
+	return d;
+}
+
+static void
+check_frame_data (shared_ptr<const EncodedData> d, int n, int size)
+{
+	BOOST_REQUIRE (d);
+	BOOST_REQUIRE_EQUAL (d->size(), size);
+	for (int i = 0; i < size; ++i) {
+		BOOST_REQUIRE_EQUAL (d->data()[i], (n * 7 + i) % 256);
+	}
+}
+
+static int
+files_in (boost::filesystem::path dir)
+{
+	int n = 0;
+	for (boost::filesystem::directory_iterator i (dir); i != boost::filesystem::directory_iterator(); ++i) {
+		++n;
+	}
+	return n;
+}
+
+/** Write frames which will not all fit in one segment, including one bigger than a
+ *  segment, then read them back in a different order.
+ */
+BOOST_AUTO_TEST_CASE (spill_log_test)
+{
+	boost::filesystem::path const dir = "build/test/spill_log_test";
+	SpillLog log (dir, 100);
+
+	/* 60 + 60 bytes will not fit in a 100-byte segment, so these go in one segment each */
+	log.write (frame_data (0, 60), 0, EYES_LEFT);
+	log.write (frame_data (1, 60), 0, EYES_RIGHT);
+	/* This one needs a segment of its own which is bigger than usual */
+	log.write (frame_data (2, 250), 1, EYES_LEFT);
+	/* And these two share one */
+	log.write (frame_data (3, 30), 1, EYES_RIGHT);
+	log.write (frame_data (4, 30), 2, EYES_LEFT);
+
+	BOOST_CHECK_EQUAL (files_in (dir), 4);
+
+	check_frame_data (log.read (1, EYES_LEFT), 2, 250);
+	check_frame_data (log.read (0, EYES_RIGHT), 1, 60);
+	check_frame_data (log.read (0, EYES_LEFT), 0, 60);
+
+	/* The segments with nothing left to read have gone */
+	BOOST_CHECK_EQUAL (files_in (dir), 1);
+
+	check_frame_data (log.read (2, EYES_LEFT), 4, 30);
+	check_frame_data (log.read (1, EYES_RIGHT), 3, 30);
+
+	/* We can carry on writing into the segment that is still open */
+	log.write (frame_data (5, 30), 2, EYES_RIGHT);
+	check_frame_data (log.read (2, EYES_RIGHT), 5, 30);
+}
+
+/** Start a SpillLog in a directory which has a partly-written segment left over from
+ *  an earlier run; it should be ignored and removed.
+ */
+BOOST_AUTO_TEST_CASE (spill_log_reopen_test)
+{
+	boost::filesystem::path const dir = "build/test/spill_log_reopen_test";
+	boost::filesystem::remove_all (dir);
+	boost::filesystem::create_directories (dir);
+
+	FILE* f = fopen_boost (dir / "0.spill", "wb");
+	BOOST_REQUIRE (f);
+	for (int i = 0; i < 45; ++i) {
+		fputc (0xff, f);
+	}
+	fclose (f);
+
+	SpillLog log (dir, 100);
+	BOOST_CHECK_EQUAL (files_in (dir), 0);
+
+	log.write (frame_data (0, 60), 0, EYES_BOTH);
+	log.write (frame_data (1, 60), 1, EYES_BOTH);
+	check_frame_data (log.read (0, EYES_BOTH), 0, 60);
+	check_frame_data (log.read (1, EYES_BOTH), 1, 60);
+}
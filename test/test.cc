@@ -68,6 +68,10 @@ struct TestConfig
 		Config::instance()->set_default_dcp_content_type (static_cast<DCPContentType*> (0));
 		Config::instance()->set_default_j2k_bandwidth (100000000);
 
+		/* Start with an empty examination cache which is nothing to do with the user's */
+		boost::filesystem::remove_all ("build/test/examination_cache");
+		Config::instance()->set_examination_cache_directory ("build/test/examination_cache");
+
 		ServerFinder::instance()->disable ();
 
 		ui_signaller = new TestUISignaller ();